@@ -0,0 +1,715 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define HAVE_TSC 1
+#else
+    #define HAVE_TSC 0
+#endif
+
+#include "board.h"
+
+//----------------------------------------------------------------------------------
+// Microbenchmark and property checks for the board functions in src/board.c
+//
+// Every run first checks the board functions against naive reference
+// implementations (mine count, safe first click, numbers, flood reveal, ...),
+// then times each function in isolation and prints the results as JSON.
+//
+// Usage: minesweeper_microbench [--reps N] [--warmup N] [--seed N] [--min-time-ms N]
+//                               [--out file.json] [--verify-only] [--no-verify]
+//----------------------------------------------------------------------------------
+
+#define MAX_REPS 1000
+#define VERIFY_SEEDS 200
+#define GEN_SLICE 1024 //Tiles per GenMapStep call, genSlice in the game
+
+struct BoardSize {
+    const char* name;
+    int w, h;
+};
+
+struct BenchCtx {
+    struct Grid grid;
+    int* clicks; //Random first clicks
+    int clickCount;
+    Vector2* pixels; //Random mouse positions, some outside the board
+    int floodStart; //Tile with the largest opening
+    long long sink; //Keeps results alive
+};
+
+struct Kernel {
+    const char* name;
+    void (*run)(struct BenchCtx* ctx, int iters);
+    void (*baseline)(struct BenchCtx* ctx, int iters); //Setup cost subtracted from run, may be NULL
+    int (*tilesPerOp)(struct BenchCtx* ctx);
+};
+
+const struct BoardSize sizes[] = {
+    {"easy", 12, 8},
+    {"medium", 16, 12},
+    {"hard", 24, 16},
+    {"large", 64, 64},
+    {"huge", 256, 256},
+};
+const int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+
+const float densities[] = {0.10f, 0.15f, 0.20f, 0.25f};
+const int densityCount = sizeof(densities) / sizeof(densities[0]);
+
+const int tileLen = 32;
+
+//----------------------------------------------------------------------------------
+// Helpers
+//----------------------------------------------------------------------------------
+long long NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+unsigned long long NowCycles(void) {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+int BombsForDensity(int len, float density) {
+    int bombCount = (int)(len * density + 0.5f);
+    if (bombCount > len - 9) {
+        bombCount = len - 9;
+    }
+    return bombCount < 0 ? 0 : bombCount;
+}
+
+int CompareLongLong(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+//----------------------------------------------------------------------------------
+// Naive reference implementations
+//----------------------------------------------------------------------------------
+int NaiveBombCount(struct Grid* gp, int tile) {
+    int tileX = tile % gp->w;
+    int tileY = tile / gp->w;
+    int bombCount = 0;
+    for (int y = tileY - 1; y <= tileY + 1; y++) {
+        for (int x = tileX - 1; x <= tileX + 1; x++) {
+            if (x >= 0 && y >= 0 && x < gp->w && y < gp->h && gp->map[x + y * gp->w] == BOMB) {
+                ++bombCount;
+            }
+        }
+    }
+    return bombCount;
+}
+
+// Same reveal as the game (first tile, then flood if it's empty) on a separate tiles buffer.
+void NaiveReveal(struct Grid* gp, int start, char* tiles) {
+    int* queue = malloc(sizeof(int) * gp->len);
+    char* seen = calloc(gp->len, 1);
+    int head = 0;
+    int tail = 0;
+
+    if (tiles[start] == UNREVEALED) {
+        tiles[start] = gp->map[start];
+    }
+    if (gp->map[start] == REVEALED) {
+        queue[tail++] = start;
+        seen[start] = 1;
+    }
+
+    while (head < tail) {
+        int tile = queue[head++];
+        if (NaiveBombCount(gp, tile) != 0) {
+            continue;
+        }
+        int tileX = tile % gp->w;
+        int tileY = tile / gp->w;
+        for (int y = tileY - 1; y <= tileY + 1; y++) {
+            for (int x = tileX - 1; x <= tileX + 1; x++) {
+                if (x < 0 || y < 0 || x >= gp->w || y >= gp->h || seen[x + y * gp->w]) {
+                    continue;
+                }
+                int pos = x + y * gp->w;
+                seen[pos] = 1;
+                queue[tail++] = pos;
+                if (tiles[pos] == UNREVEALED) {
+                    tiles[pos] = gp->map[pos];
+                }
+            }
+        }
+    }
+
+    free(queue);
+    free(seen);
+}
+
+//----------------------------------------------------------------------------------
+// Property checks
+//----------------------------------------------------------------------------------
+int failures = 0;
+
+void Fail(const char* property, struct Grid* gp, int seed, int click, const char* detail) {
+    if (failures++ < 20) {
+        fprintf(stderr, "FAIL %s: %dx%d bombs=%d seed=%d click=%d: %s\n", property, gp->w, gp->h, gp->bombCount, seed, click, detail);
+    }
+}
+
+void CheckBoard(struct Grid* gp, int seed, int click) {
+    char detail[128];
+
+    srand((unsigned int)seed);
+    SeedMap(gp, (unsigned long long)seed);
+    InitMap(gp);
+    ShuffleMap(gp, click);
+
+    // Mine count preserved
+    int mines = 0;
+    for (int i = 0; i < gp->len; i++) {
+        if (gp->map[i] == BOMB) {
+            ++mines;
+        } else if (gp->map[i] != REVEALED) {
+            Fail("shuffle-values", gp, seed, click, "tile is neither BOMB nor REVEALED");
+            return;
+        }
+    }
+    if (mines != gp->bombCount) {
+        snprintf(detail, sizeof(detail), "%d mines after shuffle", mines);
+        Fail("mine-count", gp, seed, click, detail);
+    }
+
+    // 3x3 safe first click
+    int clickX = click % gp->w;
+    int clickY = click / gp->w;
+    for (int y = clickY - 1; y <= clickY + 1; y++) {
+        for (int x = clickX - 1; x <= clickX + 1; x++) {
+            if (x >= 0 && y >= 0 && x < gp->w && y < gp->h && gp->map[x + y * gp->w] == BOMB) {
+                snprintf(detail, sizeof(detail), "bomb at %d,%d", x, y);
+                Fail("safe-first-click", gp, seed, click, detail);
+            }
+        }
+    }
+
+    // Number tiles match a brute force recount
+    GenMap(gp);
+    for (int i = 0; i < gp->len; i++) {
+        if (gp->map[i] == BOMB) {
+            continue;
+        }
+        int expected = NaiveBombCount(gp, i);
+        char want = expected == 0 ? REVEALED : NUM_TILE(expected);
+        if (gp->map[i] != want) {
+            snprintf(detail, sizeof(detail), "tile %d is %d, expected %d", i, gp->map[i], want);
+            Fail("numbers", gp, seed, click, detail);
+            break;
+        }
+    }
+
+    // GetSurroundingTiles agrees with the recount
+    int addresses[9];
+    char values[9];
+    for (int i = 0; i < gp->len; i++) {
+        if (GetSurroundingTiles(gp, i, &addresses[0], &values[0]) != NaiveBombCount(gp, i)) {
+            Fail("surrounding-tiles", gp, seed, click, "bomb count mismatch");
+            break;
+        }
+        for (int j = 0; j < 9; j++) {
+            int x = i % gp->w - 1 + (j % 3);
+            int y = i / gp->w - 1 + (j / 3);
+            int in = x >= 0 && y >= 0 && x < gp->w && y < gp->h;
+            if (addresses[j] != (in ? x + y * gp->w : -1) || (in && values[j] != gp->map[addresses[j]])) {
+                Fail("surrounding-tiles", gp, seed, click, "address mismatch");
+                i = gp->len;
+                break;
+            }
+        }
+    }
+
+    // Flood reveal matches a reference BFS, with a few random flags on the board
+    ResetTiles(gp);
+    for (int i = 0; i < gp->len / 16; i++) {
+        int tile = rand() % gp->len;
+        if (tile != click) {
+            FlagTile(gp, tile);
+        }
+    }
+    char* expected = malloc(gp->len);
+    memcpy(expected, gp->tiles, gp->len);
+    NaiveReveal(gp, click, expected);
+
+    if (RevealTile(gp, click) == 1 && gp->map[click] == REVEALED) {
+        RevealEmptyTiles(gp, click);
+    }
+
+    int revealed = 0;
+    for (int i = 0; i < gp->len; i++) {
+        if (gp->tiles[i] != expected[i]) {
+            snprintf(detail, sizeof(detail), "tile %d is %d, expected %d", i, gp->tiles[i], expected[i]);
+            Fail("flood-reveal", gp, seed, click, detail);
+            break;
+        }
+        if (gp->tiles[i] != UNREVEALED && gp->tiles[i] != FLAG) {
+            ++revealed;
+        }
+    }
+    if (revealed != gp->tilesRevealed) {
+        snprintf(detail, sizeof(detail), "tilesRevealed %d, counted %d", gp->tilesRevealed, revealed);
+        Fail("flood-counter", gp, seed, click, detail);
+    }
+    free(expected);
+
+    // Undoing an opening and clicking the same tile again opens the same tiles
+    ResetTiles(gp);
+    struct Journal journal;
+    if (JournalInit(&journal, 4, gp->len)) {
+        char* opened = malloc(gp->len);
+        gp->journal = &journal;
+        for (int pass = 0; pass < 2; pass++) {
+            JournalBegin(&journal, gp);
+            if (RevealTile(gp, click) == 1 && gp->map[click] == REVEALED) {
+                RevealEmptyTiles(gp, click);
+            }
+            JournalEnd(&journal, gp, 0);
+            if (pass == 0) {
+                memcpy(opened, gp->tiles, gp->len);
+                JournalUndo(&journal, gp);
+            }
+        }
+        if (memcmp(opened, gp->tiles, gp->len) != 0) {
+            Fail("undo-reclick", gp, seed, click, "second opening differs after undo");
+        }
+        gp->journal = NULL;
+        JournalFree(&journal);
+        free(opened);
+    }
+
+    // Flag counters, and flagging twice is a no-op
+    ResetTiles(gp);
+    for (int i = 0; i < gp->len; i++) {
+        FlagTile(gp, i);
+    }
+    if (gp->flagCount != gp->len || gp->bombsFlagged != gp->bombCount) {
+        Fail("flag-counters", gp, seed, click, "wrong counters with every tile flagged");
+    }
+    for (int i = 0; i < gp->len; i++) {
+        FlagTile(gp, i);
+    }
+    if (gp->flagCount != 0 || gp->bombsFlagged != 0 || memchr(gp->tiles, FLAG, gp->len) != NULL) {
+        Fail("flag-counters", gp, seed, click, "flags left after un-flagging");
+    }
+
+    // Revealing before the numbers exist, then numbering in slices as the game does, gives the same board
+    ResetTiles(gp);
+    if (RevealTile(gp, click) == 1 && gp->map[click] == REVEALED) {
+        RevealEmptyTiles(gp, click);
+    }
+    char* tiles = malloc(gp->len);
+    char* map = malloc(gp->len);
+    memcpy(tiles, gp->tiles, gp->len);
+    memcpy(map, gp->map, gp->len);
+
+    SeedMap(gp, (unsigned long long)seed);
+    InitMap(gp);
+    ShuffleMap(gp, click);
+    if (RevealTile(gp, click) == 1 && gp->map[click] == REVEALED) {
+        RevealEmptyTiles(gp, click);
+    }
+    if (memcmp(tiles, gp->tiles, gp->len) != 0) {
+        Fail("lazy-reveal", gp, seed, click, "flood differs before the map is numbered");
+    }
+    int steps = 0;
+    while (!GenMapStep(gp, 1 + seed % 97)) {
+        ++steps;
+    }
+    if (memcmp(map, gp->map, gp->len) != 0 || steps > gp->len) {
+        Fail("gen-map-step", gp, seed, click, "sliced numbering differs from GenMap");
+    }
+    free(tiles);
+    free(map);
+}
+
+void CheckPixelToGrid(struct Grid* gp, int seed) {
+    Vector2 origin = {40, 120};
+    srand((unsigned int)seed);
+    for (int i = 0; i < 1000; i++) {
+        Vector2 mouse = {(float)(rand() % (gp->w * tileLen + 200)) - 100 + origin.x, (float)(rand() % (gp->h * tileLen + 200)) - 100 + origin.y};
+        float dx = mouse.x - origin.x;
+        float dy = mouse.y - origin.y;
+        int expected = -1;
+        if (dx >= 0 && dy >= 0 && dx < gp->w * tileLen && dy < gp->h * tileLen) {
+            expected = (int)(dx / tileLen) + (int)(dy / tileLen) * gp->w;
+        }
+        if (PixelToGrid(gp, origin, mouse, tileLen) != expected) {
+            Fail("pixel-to-grid", gp, seed, -1, "wrong tile");
+            return;
+        }
+    }
+}
+
+int VerifyBoardProperties(void) {
+    const struct BoardSize verifySizes[] = {
+        {"tiny", 4, 4}, {"strip", 1, 24}, {"row", 24, 1}, {"easy", 12, 8},
+        {"medium", 16, 12}, {"hard", 24, 16}, {"tall", 5, 40}, {"large", 64, 64},
+    };
+    int boards = 0;
+
+    for (int s = 0; s < (int)(sizeof(verifySizes) / sizeof(verifySizes[0])); s++) {
+        for (int d = 0; d < densityCount; d++) {
+            struct Grid grid;
+            int len = verifySizes[s].w * verifySizes[s].h;
+            AllocGrid(&grid, verifySizes[s].w, verifySizes[s].h, BombsForDensity(len, densities[d]));
+
+            for (int seed = 0; seed < VERIFY_SEEDS; seed++) {
+                // Corners first, then random tiles
+                int corners[4] = {0, grid.w - 1, len - grid.w, len - 1};
+                int click = seed < 4 ? corners[seed] : (seed * 7919) % len;
+                CheckBoard(&grid, seed, click);
+                ++boards;
+            }
+            CheckPixelToGrid(&grid, d);
+
+            FreeGrid(&grid);
+        }
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "verify: %d failures over %d boards\n", failures, boards);
+        return 0;
+    }
+    fprintf(stderr, "verify: %d boards, all properties hold\n", boards);
+    return 1;
+}
+
+//----------------------------------------------------------------------------------
+// Benchmark kernels
+//----------------------------------------------------------------------------------
+void RunShuffleMap(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        ShuffleMap(&ctx->grid, ctx->clicks[i % ctx->clickCount]);
+    }
+    ctx->sink += ctx->grid.map[0];
+}
+
+void RunGenMap(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        GenMap(&ctx->grid);
+    }
+    ctx->sink += ctx->grid.map[ctx->grid.len - 1];
+}
+
+void RunGetSurroundingTiles(struct BenchCtx* ctx, int iters) {
+    int addresses[9];
+    char values[9];
+    for (int i = 0; i < iters; i++) {
+        for (int tile = 0; tile < ctx->grid.len; tile++) {
+            ctx->sink += GetSurroundingTiles(&ctx->grid, tile, &addresses[0], &values[0]);
+        }
+    }
+}
+
+void RunFloodReset(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        ResetTiles(&ctx->grid);
+        ctx->sink += RevealTile(&ctx->grid, ctx->floodStart);
+    }
+}
+
+void RunRevealEmptyTiles(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        ResetTiles(&ctx->grid);
+        ctx->sink += RevealTile(&ctx->grid, ctx->floodStart);
+        RevealEmptyTiles(&ctx->grid, ctx->floodStart);
+    }
+    ctx->sink += ctx->grid.tilesRevealed;
+}
+
+void RunPixelToGrid(struct BenchCtx* ctx, int iters) {
+    Vector2 origin = {40, 120};
+    for (int i = 0; i < iters; i++) {
+        for (int p = 0; p < ctx->grid.len; p++) {
+            ctx->sink += PixelToGrid(&ctx->grid, origin, ctx->pixels[p], tileLen);
+        }
+    }
+}
+
+void RunFlagTile(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        for (int tile = 0; tile < ctx->grid.len; tile++) {
+            FlagTile(&ctx->grid, tile);
+        }
+        for (int tile = 0; tile < ctx->grid.len; tile++) {
+            FlagTile(&ctx->grid, tile);
+        }
+    }
+    ctx->sink += ctx->grid.flagCount;
+}
+
+// The frame of a first click in the game: mines placed, the clicked tile and its opening
+// numbered on the spot and revealed. The rest of the numbers come later, see RunGenMapSlice.
+void RunFirstClick(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        int click = ctx->clicks[i % ctx->clickCount];
+        ResetTiles(&ctx->grid);
+        ShuffleMap(&ctx->grid, click);
+        ctx->sink += RevealTile(&ctx->grid, click);
+        RevealEmptyTiles(&ctx->grid, click);
+    }
+    ctx->sink += ctx->grid.tilesRevealed;
+}
+
+void RunResetTiles(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        ResetTiles(&ctx->grid);
+    }
+    ctx->sink += ctx->grid.tiles[0];
+}
+
+// One GenMapStep slice of a later frame, starting over once the map is done
+void RunGenMapSlice(struct BenchCtx* ctx, int iters) {
+    for (int i = 0; i < iters; i++) {
+        if (GenMapStep(&ctx->grid, GEN_SLICE)) {
+            ctx->grid.genPos = 0;
+        }
+    }
+    ctx->sink += ctx->grid.map[ctx->grid.len - 1];
+}
+
+int TilesPerOpLen(struct BenchCtx* ctx) {
+    return ctx->grid.len;
+}
+
+int TilesPerOpFlood(struct BenchCtx* ctx) {
+    ResetTiles(&ctx->grid);
+    RevealTile(&ctx->grid, ctx->floodStart);
+    RevealEmptyTiles(&ctx->grid, ctx->floodStart);
+    return ctx->grid.tilesRevealed;
+}
+
+int TilesPerOpFlag(struct BenchCtx* ctx) {
+    return 2 * ctx->grid.len;
+}
+
+int TilesPerOpSlice(struct BenchCtx* ctx) {
+    return ctx->grid.len < GEN_SLICE ? ctx->grid.len : GEN_SLICE;
+}
+
+const struct Kernel kernels[] = {
+    {"ShuffleMap", RunShuffleMap, NULL, TilesPerOpLen},
+    {"GenMap", RunGenMap, NULL, TilesPerOpLen},
+    {"GetSurroundingTiles", RunGetSurroundingTiles, NULL, TilesPerOpLen},
+    {"RevealEmptyTiles", RunRevealEmptyTiles, RunFloodReset, TilesPerOpFlood},
+    {"PixelToGrid", RunPixelToGrid, NULL, TilesPerOpLen},
+    {"FlagTile", RunFlagTile, NULL, TilesPerOpFlag},
+    {"FirstClick", RunFirstClick, RunResetTiles, TilesPerOpLen},
+    {"GenMapSlice", RunGenMapSlice, NULL, TilesPerOpSlice},
+};
+const int kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+
+void InitBenchCtx(struct BenchCtx* ctx, int w, int h, int bombCount, unsigned int seed) {
+    AllocGrid(&ctx->grid, w, h, bombCount);
+    ctx->sink = 0;
+
+    srand(seed);
+    SeedMap(&ctx->grid, seed);
+    ctx->clickCount = 64;
+    ctx->clicks = malloc(sizeof(int) * ctx->clickCount);
+    for (int i = 0; i < ctx->clickCount; i++) {
+        ctx->clicks[i] = rand() % ctx->grid.len;
+    }
+
+    ctx->pixels = malloc(sizeof(Vector2) * ctx->grid.len);
+    for (int i = 0; i < ctx->grid.len; i++) {
+        ctx->pixels[i] = (Vector2){(float)(rand() % (w * tileLen + 80)), (float)(rand() % (h * tileLen + 200))};
+    }
+
+    // Pick the first click with the largest opening, so the flood has real work to do
+    int best = -1;
+    for (int i = 0; i < ctx->clickCount; i++) {
+        ShuffleMap(&ctx->grid, ctx->clicks[i]);
+        GenMap(&ctx->grid);
+        ctx->floodStart = ctx->clicks[i];
+        int opened = TilesPerOpFlood(ctx);
+        if (opened > best) {
+            best = opened;
+            ctx->clicks[0] = ctx->clicks[i];
+        }
+    }
+    ctx->floodStart = ctx->clicks[0];
+    ShuffleMap(&ctx->grid, ctx->floodStart);
+    GenMap(&ctx->grid);
+    ResetTiles(&ctx->grid);
+}
+
+void FreeBenchCtx(struct BenchCtx* ctx) {
+    FreeGrid(&ctx->grid);
+    free(ctx->clicks);
+    free(ctx->pixels);
+}
+
+// Time one repetition of a kernel, minus its setup baseline.
+void TimeRep(const struct Kernel* kernel, struct BenchCtx* ctx, int iters, long long* ns, long long* cycles) {
+    long long t0 = NowNs();
+    unsigned long long c0 = NowCycles();
+    kernel->run(ctx, iters);
+    unsigned long long c1 = NowCycles();
+    long long t1 = NowNs();
+
+    *ns = t1 - t0;
+    *cycles = (long long)(c1 - c0);
+
+    if (kernel->baseline != NULL) {
+        t0 = NowNs();
+        c0 = NowCycles();
+        kernel->baseline(ctx, iters);
+        c1 = NowCycles();
+        t1 = NowNs();
+        *ns -= t1 - t0;
+        *cycles -= (long long)(c1 - c0);
+        if (*ns < 0) *ns = 0;
+        if (*cycles < 0) *cycles = 0;
+    }
+}
+
+void BenchKernel(FILE* out, const struct Kernel* kernel, struct BenchCtx* ctx, const char* sizeName, float density, int reps, int warmup, long long minTimeNs, int* first) {
+    // Restore a freshly generated board; ShuffleMap leaves a board without numbers behind
+    ShuffleMap(&ctx->grid, ctx->floodStart);
+    GenMap(&ctx->grid);
+    ResetTiles(&ctx->grid);
+
+    int tilesPerOp = kernel->tilesPerOp(ctx);
+    ResetTiles(&ctx->grid);
+
+    // Calibrate so one repetition takes at least minTimeNs
+    int iters = 1;
+    for (;;) {
+        long long t0 = NowNs();
+        kernel->run(ctx, iters);
+        if (NowNs() - t0 >= minTimeNs || iters >= (1 << 24)) {
+            break;
+        }
+        iters *= 2;
+    }
+
+    long long ns[MAX_REPS];
+    long long cycles[MAX_REPS];
+    long long ignored;
+
+    for (int i = 0; i < warmup; i++) {
+        TimeRep(kernel, ctx, iters, &ignored, &ignored);
+    }
+    for (int i = 0; i < reps; i++) {
+        TimeRep(kernel, ctx, iters, &ns[i], &cycles[i]);
+    }
+
+    qsort(ns, reps, sizeof(long long), CompareLongLong);
+    qsort(cycles, reps, sizeof(long long), CompareLongLong);
+
+    double ops = (double)iters;
+    double tiles = ops * (tilesPerOp > 0 ? tilesPerOp : 1);
+    long long medianNs = ns[reps / 2];
+    long long medianCycles = cycles[reps / 2];
+
+    fprintf(out, "%s    {\"function\": \"%s\", \"size\": \"%s\", \"w\": %d, \"h\": %d, \"bombs\": %d, \"density\": %.2f, "
+                 "\"iters\": %d, \"reps\": %d, \"tiles_per_op\": %d, "
+                 "\"ns_per_op_min\": %.2f, \"ns_per_op_median\": %.2f, \"ns_per_op_max\": %.2f, "
+                 "\"ns_per_tile\": %.4f, \"cycles_per_tile\": ",
+            *first ? "" : ",\n", kernel->name, sizeName, ctx->grid.w, ctx->grid.h, ctx->grid.bombCount, density,
+            iters, reps, tilesPerOp,
+            ns[0] / ops, medianNs / ops, ns[reps - 1] / ops,
+            medianNs / tiles);
+    if (HAVE_TSC) {
+        fprintf(out, "%.4f}", medianCycles / tiles);
+    } else {
+        fprintf(out, "null}");
+    }
+    *first = 0;
+}
+
+//----------------------------------------------------------------------------------
+// Main Entry Point
+//----------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    int reps = 15;
+    int warmup = 3;
+    unsigned int seed = 1;
+    long long minTimeNs = 2000000;
+    const char* outPath = NULL;
+    int verify = 1;
+    int bench = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+            minTimeNs = atoll(argv[++i]) * 1000000LL;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--verify-only") == 0) {
+            bench = 0;
+        } else if (strcmp(argv[i], "--no-verify") == 0) {
+            verify = 0;
+        } else {
+            fprintf(stderr, "usage: %s [--reps N] [--warmup N] [--seed N] [--min-time-ms N] [--out file.json] [--verify-only] [--no-verify]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (reps < 1) reps = 1;
+    if (reps > MAX_REPS) reps = MAX_REPS;
+    if (warmup < 0) warmup = 0;
+
+    if (verify && !VerifyBoardProperties()) {
+        return 1;
+    }
+    if (!bench) {
+        return 0;
+    }
+
+    FILE* out = stdout;
+    if (outPath != NULL) {
+        out = fopen(outPath, "w");
+        if (out == NULL) {
+            perror(outPath);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"minesweeper_microbench\",\n  \"seed\": %u,\n  \"reps\": %d,\n  \"warmup\": %d,\n  \"tsc\": %s,\n  \"results\": [\n",
+            seed, reps, warmup, HAVE_TSC ? "true" : "false");
+
+    int first = 1;
+    long long sink = 0;
+    for (int s = 0; s < sizeCount; s++) {
+        for (int d = 0; d < densityCount; d++) {
+            struct BenchCtx ctx;
+            int bombCount = BombsForDensity(sizes[s].w * sizes[s].h, densities[d]);
+            InitBenchCtx(&ctx, sizes[s].w, sizes[s].h, bombCount, seed + s * densityCount + d);
+
+            for (int k = 0; k < kernelCount; k++) {
+                BenchKernel(out, &kernels[k], &ctx, sizes[s].name, densities[d], reps, warmup, minTimeNs, &first);
+                fflush(out);
+            }
+
+            sink += ctx.sink;
+            FreeBenchCtx(&ctx);
+        }
+    }
+
+    fprintf(out, "\n  ],\n  \"sink\": %lld\n}\n", sink);
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
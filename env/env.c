@@ -0,0 +1,395 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "env.h"
+
+// One thread's share of the boards, with its own scratch buffers for RevealEmptyTiles.
+struct EnvWorker {
+    struct Env* env;
+    int index;
+    int first, last; //Boards first..last-1
+    int* tilesScanned;
+    int* scanQue;
+    pthread_t thread;
+};
+
+struct Env {
+    struct EnvConfig config;
+    int len;
+    int obsSize;
+
+    // Board state, one entry per board. tiles and map hold len bytes per board back to back.
+    char* tiles;
+    char* map;
+    int* tilesRevealed;
+    int* flagCount;
+    int* bombsFlagged;
+    int* steps;
+    unsigned long long* rngState;
+    unsigned char* started;
+
+    struct EnvWorker* workers;
+    int workerCount;
+
+    // Work handed to the workers, see EnvRun
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    long long generation;
+    int pending;
+    int running;
+    int resetting;
+    const int32_t* actions;
+    uint8_t* observations;
+    float* rewards;
+    uint8_t* dones;
+};
+
+//----------------------------------------------------------------------------------
+// Boards
+//----------------------------------------------------------------------------------
+
+// Point a Grid at one board, so the board functions can run on it.
+void LoadGrid(struct Env* env, struct EnvWorker* worker, int board, struct Grid* gp) {
+    size_t offset = (size_t)board * env->len;
+    gp->w = env->config.w;
+    gp->h = env->config.h;
+    gp->len = env->len;
+    gp->tiles = env->tiles + offset;
+    gp->map = env->map + offset;
+    gp->tilesScanned = worker->tilesScanned;
+    gp->scanQue = worker->scanQue;
+    gp->quePos = 0;
+    gp->genPos = 0; //Never numbered up front, RevealTile numbers the tiles it reveals
+    gp->bombCount = env->config.bombCount;
+    gp->bombsFlagged = env->bombsFlagged[board];
+    gp->flagCount = env->flagCount[board];
+    gp->tilesRevealed = env->tilesRevealed[board];
+    gp->rngState = env->rngState[board];
+    gp->journal = NULL;
+}
+
+void StoreGrid(struct Env* env, int board, struct Grid* gp) {
+    env->bombsFlagged[board] = gp->bombsFlagged;
+    env->flagCount[board] = gp->flagCount;
+    env->tilesRevealed[board] = gp->tilesRevealed;
+    env->rngState[board] = gp->rngState;
+}
+
+int TilePlane(char tile) {
+    if (tile == UNREVEALED) {
+        return 0;
+    } else if (tile == FLAG) {
+        return 1;
+    } else if (tile == REVEALED) {
+        return 2;
+    }
+    return 2 + tile - NUM_TILE(0);
+}
+
+void SetObservation(uint8_t* obs, int len, int tile, char before, char after) {
+    obs[TilePlane(before) * len + tile] = 0;
+    obs[TilePlane(after) * len + tile] = 1;
+}
+
+void ResetBoard(struct Env* env, struct EnvWorker* worker, int board, uint8_t* observations) {
+    struct Grid grid;
+    LoadGrid(env, worker, board, &grid);
+    InitMap(&grid);
+    StoreGrid(env, board, &grid);
+    env->started[board] = 0;
+    env->steps[board] = 0;
+
+    if (observations != NULL) {
+        uint8_t* obs = observations + (size_t)board * env->obsSize;
+        memset(obs, 0, env->obsSize);
+        memset(obs, 1, env->len);
+    }
+}
+
+// Play one action on one board. Returns the done flag.
+int StepBoard(struct Env* env, struct EnvWorker* worker, int board, int action, uint8_t* observations, float* reward) {
+    struct EnvConfig* config = &env->config;
+    uint8_t* obs = observations + (size_t)board * env->obsSize;
+    int len = env->len;
+    int done = ENV_RUNNING;
+    struct Grid grid;
+    struct Grid* gp = &grid;
+
+    LoadGrid(env, worker, board, gp);
+    *reward = config->idleReward;
+
+    if (action >= 0 && action < len) {
+        if (!env->started[board]) {
+            ShuffleMap(gp, action);
+            env->started[board] = 1;
+        }
+
+        int before = gp->tilesRevealed;
+        int revealed = RevealTile(gp, action);
+        if (revealed == -1) {
+            *reward = config->loseReward;
+            done = ENV_LOST;
+        } else if (revealed == 1) {
+            if (gp->map[action] == REVEALED) {
+                RevealEmptyTiles(gp, action);
+                // scanQue now lists every tile the flood looked at, update those
+                for (int i = 0; i < gp->quePos; i++) {
+                    int tile = gp->scanQue[i];
+                    if (gp->tiles[tile] != UNREVEALED && gp->tiles[tile] != FLAG) {
+                        SetObservation(obs, len, tile, UNREVEALED, gp->tiles[tile]);
+                    }
+                }
+            } else {
+                SetObservation(obs, len, action, UNREVEALED, gp->tiles[action]);
+            }
+
+            *reward = config->revealReward * (gp->tilesRevealed - before);
+            if (gp->tilesRevealed == len - gp->bombCount) {
+                *reward += config->winReward;
+                done = ENV_WON;
+            }
+        }
+    } else if (action >= len && action < 2 * len) {
+        int tile = action - len;
+        char before = gp->tiles[tile];
+        FlagTile(gp, tile);
+        if (gp->tiles[tile] != before) {
+            SetObservation(obs, len, tile, before, gp->tiles[tile]);
+        }
+    }
+
+    StoreGrid(env, board, gp);
+
+    if (++env->steps[board] >= config->maxSteps && config->maxSteps > 0 && done == ENV_RUNNING) {
+        done = ENV_TIMEOUT;
+    }
+    if (done != ENV_RUNNING) {
+        ResetBoard(env, worker, board, observations);
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------------------
+// Workers
+//----------------------------------------------------------------------------------
+void RunWorker(struct EnvWorker* worker) {
+    struct Env* env = worker->env;
+    if (env->resetting) {
+        for (int board = worker->first; board < worker->last; board++) {
+            ResetBoard(env, worker, board, env->observations);
+        }
+        return;
+    }
+    for (int board = worker->first; board < worker->last; board++) {
+        env->dones[board] = (uint8_t)StepBoard(env, worker, board, env->actions[board], env->observations, &env->rewards[board]);
+    }
+}
+
+void* EnvWorkerMain(void* arg) {
+    struct EnvWorker* worker = arg;
+    struct Env* env = worker->env;
+    long long seen = 0;
+
+    pthread_mutex_lock(&env->lock);
+    for (;;) {
+        while (env->running && env->generation == seen) {
+            pthread_cond_wait(&env->start, &env->lock);
+        }
+        if (!env->running) {
+            break;
+        }
+        seen = env->generation;
+        pthread_mutex_unlock(&env->lock);
+
+        RunWorker(worker);
+
+        pthread_mutex_lock(&env->lock);
+        if (--env->pending == 0) {
+            pthread_cond_signal(&env->done);
+        }
+    }
+    pthread_mutex_unlock(&env->lock);
+    return NULL;
+}
+
+// Run the current work on every worker. The calling thread takes the first share.
+void EnvRun(struct Env* env) {
+    if (env->workerCount > 1) {
+        pthread_mutex_lock(&env->lock);
+        env->pending = env->workerCount - 1;
+        ++env->generation;
+        pthread_cond_broadcast(&env->start);
+        pthread_mutex_unlock(&env->lock);
+    }
+
+    RunWorker(&env->workers[0]);
+
+    if (env->workerCount > 1) {
+        pthread_mutex_lock(&env->lock);
+        while (env->pending > 0) {
+            pthread_cond_wait(&env->done, &env->lock);
+        }
+        pthread_mutex_unlock(&env->lock);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Env API
+//----------------------------------------------------------------------------------
+
+// Rewards add up to 1 for revealing the whole board, plus winReward.
+void EnvDefaultConfig(struct EnvConfig* config, int w, int h, int bombCount, int boardCount) {
+    long long len = (long long)w * h;
+    memset(config, 0, sizeof(*config));
+    config->w = w;
+    config->h = h;
+    config->bombCount = bombCount;
+    config->boardCount = boardCount;
+    config->threadCount = 1;
+    config->maxSteps = (len > 0 && len <= BOARD_MAX_TILES) ? (int)(2 * len) : 0; //EnvCreate rejects the rest
+    config->seed = 1;
+    config->winReward = 1.0f;
+    config->loseReward = -1.0f;
+    config->revealReward = (len - bombCount > 0) ? (float)(1.0 / (len - bombCount)) : 0.0f;
+    config->idleReward = 0.0f;
+}
+
+// Returns NULL for a bad config or when out of memory. A board has at most BOARD_MAX_TILES tiles,
+// and its observation must fit in an int.
+struct Env* EnvCreate(const struct EnvConfig* config) {
+    long long len = (long long)config->w * config->h;
+    if (config->w < 1 || config->h < 1 || len > BOARD_MAX_TILES || len > INT_MAX / ENV_PLANES
+        || config->bombCount < 0 || config->bombCount > len - 9 || config->boardCount < 1 || config->threadCount < 1) {
+        return NULL;
+    }
+
+    struct Env* env = calloc(1, sizeof(struct Env));
+    if (env == NULL) {
+        return NULL;
+    }
+    env->config = *config;
+    env->len = (int)len;
+    env->obsSize = ENV_PLANES * env->len;
+    env->workerCount = config->threadCount < config->boardCount ? config->threadCount : config->boardCount;
+
+    int boards = config->boardCount;
+    env->tiles = malloc((size_t)boards * env->len);
+    env->map = malloc((size_t)boards * env->len);
+    env->tilesRevealed = calloc(boards, sizeof(int));
+    env->flagCount = calloc(boards, sizeof(int));
+    env->bombsFlagged = calloc(boards, sizeof(int));
+    env->steps = calloc(boards, sizeof(int));
+    env->rngState = calloc(boards, sizeof(unsigned long long));
+    env->started = calloc(boards, 1);
+    env->workers = calloc(env->workerCount, sizeof(struct EnvWorker));
+
+    int ok = env->tiles != NULL && env->map != NULL && env->tilesRevealed != NULL && env->flagCount != NULL && env->bombsFlagged != NULL
+             && env->steps != NULL && env->rngState != NULL && env->started != NULL && env->workers != NULL;
+
+    for (int i = 0; i < env->workerCount && ok; i++) {
+        struct EnvWorker* worker = &env->workers[i];
+        worker->env = env;
+        worker->index = i;
+        worker->first = (int)((long long)boards * i / env->workerCount);
+        worker->last = (int)((long long)boards * (i + 1) / env->workerCount);
+        worker->tilesScanned = malloc(sizeof(int) * env->len);
+        worker->scanQue = malloc(sizeof(int) * env->len);
+        ok = worker->tilesScanned != NULL && worker->scanQue != NULL;
+    }
+
+    if (!ok) {
+        env->workerCount = 0; //No threads yet
+        EnvDestroy(env);
+        return NULL;
+    }
+
+    // Every board gets its own random stream, so results don't depend on the thread count
+    for (int board = 0; board < boards; board++) {
+        struct Grid grid;
+        LoadGrid(env, &env->workers[0], board, &grid);
+        SeedBoard(&grid, config->seed, board);
+        StoreGrid(env, board, &grid);
+        ResetBoard(env, &env->workers[0], board, NULL);
+    }
+
+    pthread_mutex_init(&env->lock, NULL);
+    pthread_cond_init(&env->start, NULL);
+    pthread_cond_init(&env->done, NULL);
+    env->running = 1;
+
+    int started = 1;
+    for (; started < env->workerCount; started++) {
+        if (pthread_create(&env->workers[started].thread, NULL, EnvWorkerMain, &env->workers[started]) != 0) {
+            break;
+        }
+    }
+    if (started < env->workerCount) {
+        env->workerCount = started;
+        EnvDestroy(env);
+        return NULL;
+    }
+
+    return env;
+}
+
+void EnvDestroy(struct Env* env) {
+    if (env == NULL) {
+        return;
+    }
+
+    if (env->running) {
+        pthread_mutex_lock(&env->lock);
+        env->running = 0;
+        pthread_cond_broadcast(&env->start);
+        pthread_mutex_unlock(&env->lock);
+        for (int i = 1; i < env->workerCount; i++) {
+            pthread_join(env->workers[i].thread, NULL);
+        }
+        pthread_mutex_destroy(&env->lock);
+        pthread_cond_destroy(&env->start);
+        pthread_cond_destroy(&env->done);
+    }
+
+    if (env->workers != NULL) {
+        int workers = env->config.threadCount < env->config.boardCount ? env->config.threadCount : env->config.boardCount;
+        for (int i = 0; i < workers; i++) {
+            free(env->workers[i].tilesScanned);
+            free(env->workers[i].scanQue);
+        }
+    }
+    free(env->workers);
+    free(env->tiles);
+    free(env->map);
+    free(env->tilesRevealed);
+    free(env->flagCount);
+    free(env->bombsFlagged);
+    free(env->steps);
+    free(env->rngState);
+    free(env->started);
+    free(env);
+}
+
+int EnvObservationSize(const struct Env* env) {
+    return env->obsSize;
+}
+
+// Start a new game on every board and fill in all observations. observations holds
+// boardCount * EnvObservationSize bytes.
+void EnvReset(struct Env* env, uint8_t* observations) {
+    env->resetting = 1;
+    env->observations = observations;
+    EnvRun(env);
+}
+
+// Play actions[i] on board i. Writes rewards and dones for every board and updates observations in place.
+void EnvStep(struct Env* env, const int32_t* actions, uint8_t* observations, float* rewards, uint8_t* dones) {
+    env->resetting = 0;
+    env->actions = actions;
+    env->observations = observations;
+    env->rewards = rewards;
+    env->dones = dones;
+    EnvRun(env);
+}
@@ -0,0 +1,62 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Batched Minesweeper environment for training agents
+//
+// Steps N boards of the same size in lockstep. Board state is kept as arrays over all boards,
+// every call works on caller-owned buffers and nothing is allocated after EnvCreate.
+//
+// Actions: 0..len-1 reveals a tile, len..2*len-1 flags/un-flags tile (action - len).
+// Observations: ENV_PLANES one-hot uint8 planes of h*w per board, laid out [board][plane][y][x].
+// The observation buffer is updated in place, only tiles that changed are written, so pass the
+// buffer EnvReset filled to every EnvStep and don't modify it in between.
+// A board that finishes is reset straight away: its done flag is set and its observation
+// is already the first one of the next game.
+//----------------------------------------------------------------------------------
+
+// Only the Env functions are exported from the shared library, see env/CMakeLists.txt
+#if defined(_WIN32)
+    #if defined(ENV_BUILD_SHARED)
+        #define ENVAPI __declspec(dllexport)
+    #else
+        #define ENVAPI __declspec(dllimport)
+    #endif
+#else
+    #define ENVAPI __attribute__((visibility("default")))
+#endif
+
+#define ENV_PLANES 11 //Hidden, flagged, then revealed with 0..8 mines around
+
+// Done flags
+#define ENV_RUNNING 0
+#define ENV_WON 1
+#define ENV_LOST 2
+#define ENV_TIMEOUT 3 //Hit maxSteps
+
+struct EnvConfig {
+    int w, h, bombCount;
+    int boardCount;
+    int threadCount; //1 steps on the calling thread
+    int maxSteps; //Per game, 0 for no limit
+    unsigned long long seed;
+    float winReward, loseReward;
+    float revealReward; //Per tile revealed
+    float idleReward; //Action that changed nothing, or a flag
+};
+
+struct Env;
+
+//----------------------------------------------------------------------------------
+// Env Functions Declaration
+//----------------------------------------------------------------------------------
+ENVAPI void EnvDefaultConfig(struct EnvConfig* config, int w, int h, int bombCount, int boardCount);
+ENVAPI struct Env* EnvCreate(const struct EnvConfig* config);
+ENVAPI void EnvDestroy(struct Env* env);
+ENVAPI int EnvObservationSize(const struct Env* env); //Bytes per board
+ENVAPI void EnvReset(struct Env* env, uint8_t* observations);
+ENVAPI void EnvStep(struct Env* env, const int32_t* actions, uint8_t* observations, float* rewards, uint8_t* dones);
+
+#endif
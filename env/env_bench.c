@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "env.h"
+
+//----------------------------------------------------------------------------------
+// Throughput check for the batched environment
+//
+// Plays a random agent that clicks hidden tiles on every board and prints steps/sec as JSON.
+//
+// Usage: minesweeper_env_bench [--boards N] [--threads N] [--steps N] [--size easy|medium|hard|WxH:M] [--seed N]
+//----------------------------------------------------------------------------------
+
+double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int boards = 4096;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int steps = 1000;
+    struct Setting setting;
+    unsigned long long seed = 1;
+
+    InitDifficulty();
+    setting = medium;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--boards") == 0 && i + 1 < argc) {
+            boards = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            steps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc && ParseSetting(argv[i + 1], &setting)) {
+            ++i;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--boards N] [--threads N] [--steps N] [--size easy|medium|hard|WxH:M] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    struct EnvConfig config;
+    EnvDefaultConfig(&config, setting.w, setting.h, setting.bombCount, boards);
+    config.threadCount = threads < 1 ? 1 : threads;
+    config.seed = seed;
+
+    struct Env* env = EnvCreate(&config);
+    if (env == NULL) {
+        fprintf(stderr, "bad config or out of memory\n");
+        return 1;
+    }
+
+    int len = setting.w * setting.h;
+    int obsSize = EnvObservationSize(env);
+    uint8_t* observations = malloc((size_t)boards * obsSize);
+    int32_t* actions = malloc(sizeof(int32_t) * boards);
+    float* rewards = malloc(sizeof(float) * boards);
+    uint8_t* dones = malloc(boards);
+    if (observations == NULL || actions == NULL || rewards == NULL || dones == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    EnvReset(env, observations);
+
+    long long games = 0, won = 0;
+    double agentSeconds = 0;
+    unsigned long long rng = seed;
+    double start = NowSeconds();
+
+    for (int step = 0; step < steps; step++) {
+        // Agent: pick a random hidden tile from the hidden plane
+        double agentStart = NowSeconds();
+        for (int b = 0; b < boards; b++) {
+            const uint8_t* hidden = observations + (size_t)b * obsSize;
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            int tile = (int)((rng >> 33) % (unsigned long long)len);
+            for (int i = 0; i < len && !hidden[tile]; i++) {
+                tile = tile + 1 < len ? tile + 1 : 0;
+            }
+            actions[b] = tile;
+        }
+        agentSeconds += NowSeconds() - agentStart;
+
+        EnvStep(env, actions, observations, rewards, dones);
+
+        for (int b = 0; b < boards; b++) {
+            games += dones[b] != ENV_RUNNING;
+            won += dones[b] == ENV_WON;
+        }
+    }
+
+    double envSeconds = NowSeconds() - start - agentSeconds;
+    long long total = (long long)boards * steps;
+    printf("{\"boards\": %d, \"threads\": %d, \"size\": \"%dx%d:%d\", \"steps\": %lld, \"env_seconds\": %.3f, \"steps_per_sec\": %.0f, "
+           "\"games\": %lld, \"win_rate\": %.4f}\n",
+           boards, config.threadCount, setting.w, setting.h, setting.bombCount, total, envSeconds, envSeconds > 0 ? total / envSeconds : 0.0,
+           games, games > 0 ? (double)won / games : 0.0);
+
+    free(observations);
+    free(actions);
+    free(rewards);
+    free(dones);
+    EnvDestroy(env);
+    return 0;
+}
@@ -0,0 +1,816 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "host.h"
+
+#define MAILBOX_SIZE 16 //Commands queued per session, power of 2
+#define DEQUE_SIZE 1024 //Slots a worker keeps local, the rest go to the inject queues
+#define SLOT_BUDGET 32 //Commands run before a slot goes back to the pool, keeps sessions fair
+#define CHUNK_SIZE (1 << 20)
+#define BLOCK_CLASSES 32 //Largest block is 1 << (BLOCK_CLASSES - 1)
+#define MIN_BLOCK_CLASS 8
+#define BLOCK_HEADER ((sizeof(struct Block) + 15) & ~(size_t)15) //Block start to the session
+#define LATENCY_BUCKETS 512
+#define CACHE_LINE 64
+
+struct Command {
+    int type;
+    int tile;
+    unsigned int generation; //Of the session the command was sent to
+    int w, h, bombCount;
+    unsigned long long seed;
+    struct HostCallback callback;
+    long long submitNs;
+};
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Each cell is a sequence number followed by the element.
+struct Queue {
+    unsigned char* cells;
+    size_t stride, mask, elemSize;
+    char pad0[CACHE_LINE];
+    atomic_size_t enqPos;
+    char pad1[CACHE_LINE];
+    atomic_size_t deqPos;
+    char pad2[CACHE_LINE];
+};
+
+// Chase-Lev work-stealing deque with a fixed capacity. The owner pushes and pops at the bottom, thieves take from the top.
+struct Deque {
+    atomic_llong top;
+    char pad0[CACHE_LINE];
+    atomic_llong bottom;
+    char pad1[CACHE_LINE];
+    _Atomic(struct Slot*)* buf;
+    long long mask;
+};
+
+// Memory block holding one whole session. Its size is 1 << sizeClass.
+struct Block {
+    int sizeClass;
+    struct Block* next;
+};
+
+struct Chunk {
+    struct Chunk* next;
+};
+
+// Per-worker block allocator: free lists per size class, carved from big chunks.
+struct Pool {
+    struct Block* free[BLOCK_CLASSES];
+    char* chunk;
+    size_t chunkUsed, chunkCap;
+    struct Chunk* chunks;
+};
+
+// Bump allocator over a session's block.
+struct Arena {
+    char* base;
+    size_t used, cap;
+};
+
+struct Session {
+    struct Block* block;
+    struct Arena arena;
+    struct Grid grid;
+    int stage;
+    unsigned int generation;
+};
+
+struct Slot {
+    struct Queue mailbox;
+    atomic_int scheduled; //1 while the slot is queued or running on a worker
+    atomic_int inUse;
+    atomic_uint generation; //Bumped every time the slot is opened, see SessionId
+    struct Session* session; //Only touched by the worker running the slot
+};
+
+struct Worker {
+    struct Host* host;
+    int index;
+    pthread_t thread;
+    struct Deque deque;
+    struct Queue inject; //Slots scheduled from outside the pool
+    struct Pool pool;
+    unsigned long long rngState;
+
+    // Written by this worker only, read by HostGetStats
+    atomic_llong commands, opened, closed, finished, steals;
+    atomic_llong latency[LATENCY_BUCKETS];
+    char pad[CACHE_LINE];
+};
+
+struct Host {
+    struct Worker* workers;
+    int workerCount;
+    struct Slot* slots;
+    int maxSessions;
+    int slotBits; //Low bits of a session id that hold the slot index
+    unsigned int generationMask;
+    atomic_uint nextSlot;
+    atomic_uint nextInject;
+    atomic_int running;
+    long long latencyBase[LATENCY_BUCKETS]; //Subtracted from the worker histograms, see HostResetLatency
+};
+
+_Thread_local struct Worker* currentWorker = NULL;
+
+//----------------------------------------------------------------------------------
+// Helpers
+//----------------------------------------------------------------------------------
+long long HostNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+size_t NextPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Log-linear buckets: exact below 16ns, then 16 buckets per power of two.
+int LatencyBucket(long long ns) {
+    if (ns < 16) {
+        return ns < 0 ? 0 : (int)ns;
+    }
+    int e = 63 - __builtin_clzll((unsigned long long)ns);
+    int index = 16 + (e - 4) * 16 + (int)((ns >> (e - 4)) & 15);
+    return index < LATENCY_BUCKETS ? index : LATENCY_BUCKETS - 1;
+}
+
+long long LatencyBucketValue(int index) {
+    if (index < 16) {
+        return index;
+    }
+    int e = (index - 16) / 16 + 4;
+    return (long long)(16 + (index - 16) % 16) << (e - 4);
+}
+
+// A session id is the slot index in the low slotBits bits with the slot's generation above it, so an
+// id stops working once its session is closed, even if the slot is opened again for someone else.
+int SessionId(struct Host* host, int index, unsigned int generation) {
+    return (int)(((generation & host->generationMask) << host->slotBits) | (unsigned int)index);
+}
+
+// Single writer counter, no locked instruction needed.
+void CounterAdd(atomic_llong* counter, long long value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------
+// Queue
+//----------------------------------------------------------------------------------
+int QueueInit(struct Queue* q, size_t capacity, size_t elemSize) {
+    capacity = NextPowerOfTwo(capacity < 2 ? 2 : capacity);
+    q->elemSize = elemSize;
+    q->stride = sizeof(atomic_size_t) + ((elemSize + 7) & ~(size_t)7);
+    q->mask = capacity - 1;
+    q->cells = malloc(q->stride * capacity);
+    if (q->cells == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init((atomic_size_t*)(q->cells + i * q->stride), i);
+    }
+    atomic_init(&q->enqPos, 0);
+    atomic_init(&q->deqPos, 0);
+    return 1;
+}
+
+void QueueFree(struct Queue* q) {
+    free(q->cells);
+    q->cells = NULL;
+}
+
+int QueuePush(struct Queue* q, const void* elem) {
+    size_t pos = atomic_load_explicit(&q->enqPos, memory_order_relaxed);
+    unsigned char* cell;
+    for (;;) {
+        cell = q->cells + (pos & q->mask) * q->stride;
+        size_t seq = atomic_load_explicit((atomic_size_t*)cell, memory_order_acquire);
+        long long dif = (long long)seq - (long long)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enqPos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&q->enqPos, memory_order_relaxed);
+        }
+    }
+    memcpy(cell + sizeof(atomic_size_t), elem, q->elemSize);
+    atomic_store_explicit((atomic_size_t*)cell, pos + 1, memory_order_release);
+    return 1;
+}
+
+int QueuePop(struct Queue* q, void* elem) {
+    size_t pos = atomic_load_explicit(&q->deqPos, memory_order_relaxed);
+    unsigned char* cell;
+    for (;;) {
+        cell = q->cells + (pos & q->mask) * q->stride;
+        size_t seq = atomic_load_explicit((atomic_size_t*)cell, memory_order_acquire);
+        long long dif = (long long)seq - (long long)(pos + 1);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->deqPos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&q->deqPos, memory_order_relaxed);
+        }
+    }
+    memcpy(elem, cell + sizeof(atomic_size_t), q->elemSize);
+    atomic_store_explicit((atomic_size_t*)cell, pos + q->mask + 1, memory_order_release);
+    return 1;
+}
+
+int QueueEmpty(struct Queue* q) {
+    size_t pos = atomic_load(&q->deqPos);
+    unsigned char* cell = q->cells + (pos & q->mask) * q->stride;
+    return atomic_load((atomic_size_t*)cell) != pos + 1;
+}
+
+//----------------------------------------------------------------------------------
+// Deque
+//----------------------------------------------------------------------------------
+int DequeInit(struct Deque* d, size_t capacity) {
+    capacity = NextPowerOfTwo(capacity < 2 ? 2 : capacity);
+    d->buf = malloc(sizeof(*d->buf) * capacity);
+    if (d->buf == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&d->buf[i], NULL);
+    }
+    d->mask = (long long)capacity - 1;
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    return 1;
+}
+
+void DequeFree(struct Deque* d) {
+    free(d->buf);
+    d->buf = NULL;
+}
+
+int DequePush(struct Deque* d, struct Slot* slot) {
+    long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - t > d->mask) {
+        return 0;
+    }
+    atomic_store_explicit(&d->buf[b & d->mask], slot, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 1;
+}
+
+struct Slot* DequePop(struct Deque* d) {
+    long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    struct Slot* slot = atomic_load_explicit(&d->buf[b & d->mask], memory_order_relaxed);
+    if (t == b) {
+        // Last item, race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            slot = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return slot;
+}
+
+struct Slot* DequeSteal(struct Deque* d) {
+    long long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return NULL;
+    }
+
+    struct Slot* slot = atomic_load_explicit(&d->buf[t & d->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return slot;
+}
+
+//----------------------------------------------------------------------------------
+// Pool and arena
+//----------------------------------------------------------------------------------
+// A block with room for size bytes after BLOCK_HEADER. NULL if that's more than the largest class.
+struct Block* PoolAlloc(struct Pool* pool, size_t size) {
+    if (size > ((size_t)1 << (BLOCK_CLASSES - 1)) - BLOCK_HEADER) {
+        return NULL;
+    }
+    int sizeClass = MIN_BLOCK_CLASS;
+    while (((size_t)1 << sizeClass) < size + BLOCK_HEADER) {
+        ++sizeClass;
+    }
+    size_t blockSize = (size_t)1 << sizeClass;
+
+    struct Block* block = pool->free[sizeClass];
+    if (block != NULL) {
+        pool->free[sizeClass] = block->next;
+        return block;
+    }
+
+    if (pool->chunk == NULL || pool->chunkUsed + blockSize > pool->chunkCap) {
+        size_t chunkCap = blockSize > CHUNK_SIZE ? blockSize : CHUNK_SIZE;
+        struct Chunk* chunk = malloc(sizeof(struct Chunk) + 16 + chunkCap);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        pool->chunk = (char*)chunk + ((sizeof(struct Chunk) + 15) & ~(size_t)15);
+        pool->chunkUsed = 0;
+        pool->chunkCap = chunkCap;
+    }
+
+    block = (struct Block*)(pool->chunk + pool->chunkUsed);
+    pool->chunkUsed += blockSize;
+    block->sizeClass = sizeClass;
+    return block;
+}
+
+// O(1): the block goes on the free list of whichever worker closed the session.
+void PoolRelease(struct Pool* pool, struct Block* block) {
+    block->next = pool->free[block->sizeClass];
+    pool->free[block->sizeClass] = block;
+}
+
+void PoolFree(struct Pool* pool) {
+    while (pool->chunks != NULL) {
+        struct Chunk* next = pool->chunks->next;
+        free(pool->chunks);
+        pool->chunks = next;
+    }
+}
+
+void* ArenaAlloc(struct Arena* arena, size_t size) {
+    size_t start = (arena->used + 15) & ~(size_t)15;
+    if (start + size > arena->cap) {
+        return NULL;
+    }
+    arena->used = start + size;
+    return arena->base + start;
+}
+
+//----------------------------------------------------------------------------------
+// Sessions
+//----------------------------------------------------------------------------------
+struct Session* OpenSession(struct Pool* pool, struct Command* cmd) {
+    int len = cmd->w * cmd->h;
+    size_t arenaSize = 2 * (size_t)len + 2 * sizeof(int) * (size_t)len + 4 * 16;
+    size_t size = ((sizeof(struct Session) + 15) & ~(size_t)15) + arenaSize;
+
+    struct Block* block = PoolAlloc(pool, size);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    struct Session* session = (struct Session*)((char*)block + BLOCK_HEADER);
+    session->block = block;
+    session->arena.base = (char*)session + ((sizeof(struct Session) + 15) & ~(size_t)15);
+    session->arena.used = 0;
+    session->arena.cap = arenaSize;
+
+    struct Grid* gp = &session->grid;
+    gp->w = cmd->w;
+    gp->h = cmd->h;
+    gp->len = len;
+    gp->bombCount = cmd->bombCount;
+    gp->tiles = ArenaAlloc(&session->arena, len);
+    gp->map = ArenaAlloc(&session->arena, len);
+    gp->tilesScanned = ArenaAlloc(&session->arena, sizeof(int) * len);
+    gp->scanQue = ArenaAlloc(&session->arena, sizeof(int) * len);
+    gp->quePos = 0;
+    gp->journal = NULL;
+
+    SeedMap(gp, cmd->seed);
+    InitMap(gp);
+    session->stage = SESSION_NOT_STARTED;
+    return session;
+}
+
+// Left click, as UpdateDrawFrame does it. Returns 1 if the game ended.
+int SessionReveal(struct Session* session, int tile) {
+    struct Grid* gp = &session->grid;
+
+    if (session->stage == SESSION_NOT_STARTED) {
+        session->stage = SESSION_STARTED;
+        ShuffleMap(gp, tile);
+        GenMap(gp);
+    }
+    if (session->stage != SESSION_STARTED) {
+        return 0;
+    }
+
+    int revealed = RevealTile(gp, tile);
+    if (revealed == 1 && gp->map[tile] == REVEALED) {
+        RevealEmptyTiles(gp, tile);
+    } else if (revealed == -1) {
+        session->stage = SESSION_LOST;
+        return 1;
+    }
+
+    if (gp->tilesRevealed == gp->len - gp->bombCount) {
+        session->stage = SESSION_WON;
+        return 1;
+    }
+    return 0;
+}
+
+void RunCommand(struct Worker* worker, struct Slot* slot, struct Command* cmd) {
+    struct HostResult result;
+    memset(&result, 0, sizeof(result));
+    result.session = SessionId(worker->host, (int)(slot - worker->host->slots), cmd->generation);
+    result.command = cmd->type;
+    result.status = HOST_OK;
+
+    struct Session* session = slot->session;
+    if (cmd->type != HOST_OPEN && session != NULL && session->generation != cmd->generation) {
+        session = NULL; //Sent to an earlier session of this slot
+    }
+    int valid = session != NULL && cmd->tile >= 0 && cmd->tile < session->grid.len;
+
+    switch (cmd->type) {
+        case HOST_OPEN: {
+            if (session != NULL) {
+                result.status = HOST_ERROR;
+                break;
+            }
+            slot->session = session = OpenSession(&worker->pool, cmd);
+            if (session == NULL) {
+                result.status = HOST_ERROR;
+                atomic_store(&slot->inUse, 0);
+                break;
+            }
+            session->generation = cmd->generation;
+            CounterAdd(&worker->opened, 1);
+            break;
+        }
+        case HOST_REVEAL: {
+            if (!valid) {
+                result.status = HOST_ERROR;
+                break;
+            }
+            CounterAdd(&worker->finished, SessionReveal(session, cmd->tile));
+            break;
+        }
+        case HOST_FLAG: {
+            if (!valid) {
+                result.status = HOST_ERROR;
+                break;
+            }
+            if (session->stage == SESSION_NOT_STARTED || session->stage == SESSION_STARTED) {
+                FlagTile(&session->grid, cmd->tile);
+            }
+            break;
+        }
+        case HOST_STATE: {
+            if (session == NULL) {
+                result.status = HOST_ERROR;
+            }
+            break;
+        }
+        case HOST_CLOSE: {
+            if (session == NULL) {
+                result.status = HOST_ERROR;
+                break;
+            }
+            PoolRelease(&worker->pool, session->block);
+            slot->session = session = NULL;
+            CounterAdd(&worker->closed, 1);
+            atomic_store(&slot->inUse, 0);
+            break;
+        }
+        default: {
+            result.status = HOST_ERROR;
+            break;
+        }
+    }
+
+    if (session != NULL) {
+        result.stage = session->stage;
+        result.w = session->grid.w;
+        result.h = session->grid.h;
+        result.bombCount = session->grid.bombCount;
+        result.tilesRevealed = session->grid.tilesRevealed;
+        result.flagCount = session->grid.flagCount;
+        result.tiles = session->grid.tiles;
+    }
+
+    result.latencyNs = HostNowNs() - cmd->submitNs;
+    CounterAdd(&worker->latency[LatencyBucket(result.latencyNs)], 1);
+    CounterAdd(&worker->commands, 1);
+
+    if (cmd->callback.done != NULL) {
+        cmd->callback.done(cmd->callback.user, &result);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Scheduler
+//----------------------------------------------------------------------------------
+void Schedule(struct Host* host, struct Slot* slot) {
+    struct Worker* worker = currentWorker;
+    if (worker != NULL && worker->host == host && DequePush(&worker->deque, slot)) {
+        return;
+    }
+
+    // Together the inject queues hold every slot at once, and a slot is queued in one place at a time,
+    // so this only spins on contention
+    for (;;) {
+        unsigned int index = atomic_fetch_add_explicit(&host->nextInject, 1, memory_order_relaxed) % host->workerCount;
+        if (QueuePush(&host->workers[index].inject, &slot)) {
+            return;
+        }
+    }
+}
+
+void RunSlot(struct Worker* worker, struct Slot* slot) {
+    struct Command cmd;
+    for (int i = 0; i < SLOT_BUDGET && QueuePop(&slot->mailbox, &cmd); i++) {
+        RunCommand(worker, slot, &cmd);
+    }
+
+    atomic_store(&slot->scheduled, 0);
+
+    // A command may have arrived after the mailbox looked empty; whoever flips scheduled back schedules it
+    if (!QueueEmpty(&slot->mailbox) && atomic_exchange(&slot->scheduled, 1) == 0) {
+        Schedule(worker->host, slot);
+    }
+}
+
+struct Slot* FindWork(struct Worker* worker) {
+    struct Host* host = worker->host;
+    struct Slot* slot = DequePop(&worker->deque);
+
+    if (slot != NULL || QueuePop(&worker->inject, &slot)) {
+        return slot;
+    }
+
+    // Steal, starting from a random victim
+    worker->rngState = worker->rngState * 6364136223846793005ULL + 1442695040888963407ULL;
+    int start = (int)((worker->rngState >> 33) % (unsigned long long)host->workerCount);
+    for (int i = 0; i < host->workerCount; i++) {
+        struct Worker* victim = &host->workers[(start + i) % host->workerCount];
+        if (victim == worker) {
+            continue;
+        }
+        slot = DequeSteal(&victim->deque);
+        if (slot != NULL || QueuePop(&victim->inject, &slot)) {
+            CounterAdd(&worker->steals, 1);
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+void* WorkerMain(void* arg) {
+    struct Worker* worker = arg;
+    currentWorker = worker;
+    int idle = 0;
+
+    while (atomic_load_explicit(&worker->host->running, memory_order_relaxed)) {
+        struct Slot* slot = FindWork(worker);
+        if (slot != NULL) {
+            RunSlot(worker, slot);
+            idle = 0;
+            continue;
+        }
+
+        // Back off: yield first, then sleep for up to 1ms
+        if (++idle < 64) {
+            sched_yield();
+        } else {
+            struct timespec wait = {0, idle < 1024 ? 50000 : 1000000};
+            nanosleep(&wait, NULL);
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------
+// Host API
+//----------------------------------------------------------------------------------
+struct Host* HostCreate(int workerCount, int maxSessions) {
+    if (workerCount < 1 || maxSessions < 1 || maxSessions > HOST_MAX_SESSIONS) {
+        return NULL;
+    }
+
+    struct Host* host = calloc(1, sizeof(struct Host));
+    if (host == NULL) {
+        return NULL;
+    }
+    host->workerCount = workerCount;
+    host->maxSessions = maxSessions;
+    while ((1 << host->slotBits) < maxSessions) {
+        ++host->slotBits;
+    }
+    host->generationMask = (1u << (31 - host->slotBits)) - 1;
+    atomic_init(&host->nextSlot, 0);
+    atomic_init(&host->nextInject, 0);
+    atomic_init(&host->running, 1);
+
+    host->slots = calloc(maxSessions, sizeof(struct Slot));
+    host->workers = calloc(workerCount, sizeof(struct Worker));
+    if (host->slots == NULL || host->workers == NULL) {
+        free(host->slots);
+        free(host->workers);
+        free(host);
+        return NULL;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < maxSessions && ok; i++) {
+        atomic_init(&host->slots[i].scheduled, 0);
+        atomic_init(&host->slots[i].inUse, 0);
+        atomic_init(&host->slots[i].generation, 0);
+        ok = QueueInit(&host->slots[i].mailbox, MAILBOX_SIZE, sizeof(struct Command));
+    }
+    for (int i = 0; i < workerCount && ok; i++) {
+        struct Worker* worker = &host->workers[i];
+        worker->host = host;
+        worker->index = i;
+        worker->rngState = 0x9E3779B97F4A7C15ULL * (i + 1);
+        ok = DequeInit(&worker->deque, maxSessions < DEQUE_SIZE ? maxSessions : DEQUE_SIZE) &&
+             QueueInit(&worker->inject, (maxSessions + workerCount - 1) / workerCount, sizeof(struct Slot*));
+    }
+
+    int started = 0;
+    for (; started < workerCount && ok; started++) {
+        ok = pthread_create(&host->workers[started].thread, NULL, WorkerMain, &host->workers[started]) == 0;
+        if (!ok) {
+            break;
+        }
+    }
+
+    if (!ok) {
+        atomic_store(&host->running, 0);
+        for (int i = 0; i < started; i++) {
+            pthread_join(host->workers[i].thread, NULL);
+        }
+        host->workerCount = 0; //Threads are joined, only free memory
+        for (int i = 0; i < workerCount; i++) {
+            DequeFree(&host->workers[i].deque);
+            QueueFree(&host->workers[i].inject);
+        }
+        for (int i = 0; i < maxSessions; i++) {
+            QueueFree(&host->slots[i].mailbox);
+        }
+        free(host->slots);
+        free(host->workers);
+        free(host);
+        return NULL;
+    }
+
+    return host;
+}
+
+// Stop the workers and free everything, open sessions included.
+void HostDestroy(struct Host* host) {
+    atomic_store(&host->running, 0);
+    for (int i = 0; i < host->workerCount; i++) {
+        pthread_join(host->workers[i].thread, NULL);
+    }
+    for (int i = 0; i < host->workerCount; i++) {
+        DequeFree(&host->workers[i].deque);
+        QueueFree(&host->workers[i].inject);
+        PoolFree(&host->workers[i].pool);
+    }
+    for (int i = 0; i < host->maxSessions; i++) {
+        QueueFree(&host->slots[i].mailbox);
+    }
+    free(host->slots);
+    free(host->workers);
+    free(host);
+}
+
+int SubmitCommand(struct Host* host, struct Slot* slot, struct Command* cmd) {
+    cmd->submitNs = HostNowNs();
+    if (!QueuePush(&slot->mailbox, cmd)) {
+        return HOST_BUSY;
+    }
+    if (atomic_exchange(&slot->scheduled, 1) == 0) {
+        Schedule(host, slot);
+    }
+    return HOST_OK;
+}
+
+// Open a new session in a free slot. Returns the session id, HOST_BUSY if every slot is taken,
+// or HOST_ERROR for a bad setting. The callback gets the HOST_OPEN result.
+int HostOpenSession(struct Host* host, int w, int h, int bombCount, unsigned long long seed, struct HostCallback callback) {
+    if (w < 1 || h < 1 || (long long)w * h > HOST_MAX_TILES || bombCount < 0 || bombCount > w * h - 9) {
+        return HOST_ERROR;
+    }
+
+    for (int i = 0; i < host->maxSessions; i++) {
+        unsigned int index = atomic_fetch_add_explicit(&host->nextSlot, 1, memory_order_relaxed) % host->maxSessions;
+        struct Slot* slot = &host->slots[index];
+        int expected = 0;
+        if (!atomic_compare_exchange_strong(&slot->inUse, &expected, 1)) {
+            continue;
+        }
+
+        // Only the thread holding inUse writes the generation
+        unsigned int generation = (atomic_load(&slot->generation) + 1) & host->generationMask;
+        atomic_store(&slot->generation, generation);
+
+        struct Command cmd = {HOST_OPEN, 0, generation, w, h, bombCount, seed, callback, 0};
+        if (SubmitCommand(host, slot, &cmd) != HOST_OK) {
+            atomic_store(&slot->inUse, 0);
+            return HOST_BUSY;
+        }
+        return SessionId(host, (int)index, generation);
+    }
+    return HOST_BUSY;
+}
+
+// Queue a command for a session. The callback runs on a worker once it's done. Ids of closed
+// sessions get HOST_ERROR, here or, if the close was still queued, from the worker.
+int HostSubmit(struct Host* host, int session, int command, int tile, struct HostCallback callback) {
+    int index = session & ((1 << host->slotBits) - 1);
+    unsigned int generation = (unsigned int)session >> host->slotBits;
+    if (session < 0 || index >= host->maxSessions || command == HOST_OPEN) {
+        return HOST_ERROR;
+    }
+    struct Slot* slot = &host->slots[index];
+    if (!atomic_load(&slot->inUse) || atomic_load(&slot->generation) != generation) {
+        return HOST_ERROR;
+    }
+
+    struct Command cmd = {command, tile, generation, 0, 0, 0, 0, callback, 0};
+    return SubmitCommand(host, slot, &cmd);
+}
+
+void HostGetStats(struct Host* host, struct HostStats* stats) {
+    long long latency[LATENCY_BUCKETS] = {0};
+    memset(stats, 0, sizeof(*stats));
+    stats->workers = host->workerCount;
+
+    for (int i = 0; i < host->workerCount; i++) {
+        struct Worker* worker = &host->workers[i];
+        stats->commands += atomic_load_explicit(&worker->commands, memory_order_relaxed);
+        stats->sessionsOpened += atomic_load_explicit(&worker->opened, memory_order_relaxed);
+        stats->sessionsClosed += atomic_load_explicit(&worker->closed, memory_order_relaxed);
+        stats->gamesFinished += atomic_load_explicit(&worker->finished, memory_order_relaxed);
+        stats->steals += atomic_load_explicit(&worker->steals, memory_order_relaxed);
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            latency[b] += atomic_load_explicit(&worker->latency[b], memory_order_relaxed);
+        }
+    }
+
+    long long total = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        latency[b] -= host->latencyBase[b];
+        if (latency[b] < 0) latency[b] = 0;
+        total += latency[b];
+    }
+
+    long long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (latency[b] == 0) {
+            continue;
+        }
+        seen += latency[b];
+        if (stats->p50Ns == 0 && seen * 2 >= total) {
+            stats->p50Ns = LatencyBucketValue(b);
+        }
+        if (stats->p99Ns == 0 && seen * 100 >= total * 99) {
+            stats->p99Ns = LatencyBucketValue(b);
+        }
+        stats->maxNs = LatencyBucketValue(b);
+    }
+}
+
+// Start a new latency window, e.g. after warm-up. The workers' counters are left alone, the
+// current totals are remembered and subtracted by HostGetStats.
+void HostResetLatency(struct Host* host) {
+    memset(host->latencyBase, 0, sizeof(host->latencyBase));
+    for (int i = 0; i < host->workerCount; i++) {
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            host->latencyBase[b] += atomic_load_explicit(&host->workers[i].latency[b], memory_order_relaxed);
+        }
+    }
+}
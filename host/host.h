@@ -0,0 +1,71 @@
+#ifndef HOST_H
+#define HOST_H
+
+//----------------------------------------------------------------------------------
+// Multi-session game host
+//
+// Runs thousands of independent games in one process. Every session lives in a slot with
+// its own mailbox; commands are queued there and the slot is scheduled onto a work-stealing
+// thread pool. Only one worker runs a slot at a time, so a session is only ever written by
+// one thread and no locks are needed. Session memory comes from one arena block, taken from
+// the worker's pool on open and given back in O(1) on close. Session ids carry the slot's
+// generation, so commands for a closed session never reach the next game in its slot.
+//----------------------------------------------------------------------------------
+
+#define HOST_OPEN 0
+#define HOST_REVEAL 1
+#define HOST_FLAG 2
+#define HOST_STATE 3
+#define HOST_CLOSE 4
+
+#define HOST_MAX_TILES (1 << 22) //Largest w * h a session may have
+#define HOST_MAX_SESSIONS (1 << 16) //Each slot costs about 1.3 KiB up front, mostly its mailbox. Leaves 15 bits of generation in a session id
+
+#define HOST_OK 0
+#define HOST_ERROR (-1) //Bad session, tile or setting
+#define HOST_BUSY (-2) //Mailbox or host full, try again
+
+// Session stage, same values as gameStage in the game
+#define SESSION_LOST (-1)
+#define SESSION_NOT_STARTED 0
+#define SESSION_STARTED 1
+#define SESSION_WON 3
+
+struct Host;
+
+struct HostResult {
+    int session;
+    int command;
+    int status;
+    int stage;
+    int w, h, bombCount;
+    int tilesRevealed, flagCount;
+    const char* tiles; //Player's view of the board, only valid during the callback
+    long long latencyNs; //From submit to completion
+};
+
+// Called on a worker thread when a command is done. May submit more commands.
+struct HostCallback {
+    void (*done)(void* user, const struct HostResult* result);
+    void* user;
+};
+
+struct HostStats {
+    int workers;
+    long long commands;
+    long long sessionsOpened, sessionsClosed, gamesFinished;
+    long long steals;
+    long long p50Ns, p99Ns, maxNs; //Command latency
+};
+
+//----------------------------------------------------------------------------------
+// Host Functions Declaration
+//----------------------------------------------------------------------------------
+struct Host* HostCreate(int workerCount, int maxSessions);
+void HostDestroy(struct Host* host);
+int HostOpenSession(struct Host* host, int w, int h, int bombCount, unsigned long long seed, struct HostCallback callback);
+int HostSubmit(struct Host* host, int session, int command, int tile, struct HostCallback callback);
+void HostGetStats(struct Host* host, struct HostStats* stats);
+void HostResetLatency(struct Host* host);
+
+#endif
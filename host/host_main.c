@@ -0,0 +1,439 @@
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "host.h"
+
+//----------------------------------------------------------------------------------
+// Game host command interface and load generator
+//
+// Interactive: one command per line on stdin, one reply per line on stdout.
+//   open easy|medium|hard [seed]     open W H BOMBS [seed]
+//   reveal ID TILE    flag ID TILE    state ID    show ID    close ID
+//   stats    quit
+//
+// Benchmark: --bench plays random games in every session, reopening them as games end,
+// and prints sessions/sec and command latency once per second.
+//
+// Verification: --bench --verify has every player keep a batch of numbered commands in flight
+// and checks in the callbacks that each session's commands complete in the order they were
+// sent and that no two callbacks of a session ever overlap, i.e. that one worker at a time
+// runs a slot however it's stolen. Exits 1 on any violation. Use fewer sessions than threads,
+// so idle workers steal the sessions each game opens.
+//
+// Usage: minesweeper_host [--threads N] [--max-sessions N]
+//                         [--bench [--verify] [--sessions N] [--seconds N] [--setting easy|medium|hard|WxH:M]]
+//----------------------------------------------------------------------------------
+
+#define VERIFY_BATCH 8 //Commands in flight per player with --verify, less than the mailbox holds
+
+// Reply to a command from the interactive interface.
+struct Pending {
+    atomic_int done;
+    struct HostResult result;
+    char* tiles;
+};
+
+struct Agent;
+
+// A numbered command sent with --verify
+struct Ticket {
+    struct Agent* agent;
+    long long seq;
+};
+
+// One simulated player in --bench mode. It has at most one command in flight, or one batch with --verify.
+struct Agent {
+    struct Host* host;
+    struct Setting setting;
+    unsigned long long rngState;
+    int failed;
+
+    // --verify only
+    int verify;
+    long long sent, done; //Commands numbered and completed so far
+    atomic_int inCallback;
+    struct Ticket tickets[VERIFY_BATCH];
+};
+
+atomic_int stopping = 0;
+atomic_llong verifiedCommands = 0;
+atomic_llong outOfOrder = 0;
+atomic_llong overlaps = 0;
+
+//----------------------------------------------------------------------------------
+// Helpers
+//----------------------------------------------------------------------------------
+double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void PrintStats(struct HostStats* stats, double seconds, long long finished, long long commands) {
+    printf("{\"workers\": %d, \"seconds\": %.2f, \"sessions_per_sec\": %.1f, \"commands_per_sec\": %.1f, "
+           "\"sessions_opened\": %lld, \"sessions_closed\": %lld, \"games_finished\": %lld, \"commands\": %lld, \"steals\": %lld, "
+           "\"latency_p50_us\": %.2f, \"latency_p99_us\": %.2f, \"latency_max_us\": %.2f}\n",
+           stats->workers, seconds, seconds > 0 ? finished / seconds : 0.0, seconds > 0 ? commands / seconds : 0.0,
+           stats->sessionsOpened, stats->sessionsClosed, stats->gamesFinished, stats->commands, stats->steals,
+           stats->p50Ns / 1000.0, stats->p99Ns / 1000.0, stats->maxNs / 1000.0);
+    fflush(stdout);
+}
+
+//----------------------------------------------------------------------------------
+// Interactive interface
+//----------------------------------------------------------------------------------
+void PendingDone(void* user, const struct HostResult* result) {
+    struct Pending* pending = user;
+    pending->result = *result;
+    pending->result.tiles = NULL;
+    if (result->tiles != NULL) {
+        pending->tiles = malloc(result->w * result->h);
+        if (pending->tiles != NULL) {
+            memcpy(pending->tiles, result->tiles, result->w * result->h);
+        }
+    }
+    atomic_store(&pending->done, 1);
+}
+
+void WaitPending(struct Pending* pending) {
+    while (!atomic_load(&pending->done)) {
+        sched_yield();
+    }
+}
+
+char TileChar(char tile) {
+    if (tile >= NUM_TILE(1) && tile <= NUM_TILE(8)) {
+        return (char)('0' + tile - NUM_TILE(0));
+    }
+    switch (tile) {
+        case UNREVEALED: return '#';
+        case REVEALED: return '.';
+        case FLAG: return 'F';
+        case BOMB: return '*';
+        case BOMB_RED: return 'X';
+        case BOMB_CROSS: return 'x';
+    }
+    return '?';
+}
+
+void PrintReply(struct Pending* pending, int show) {
+    struct HostResult* result = &pending->result;
+    if (result->status != HOST_OK) {
+        printf("error %d\n", result->status);
+        return;
+    }
+    printf("ok %d %d %d %d %d %d %d\n", result->session, result->stage, result->w, result->h, result->bombCount, result->tilesRevealed, result->flagCount);
+    if (show && pending->tiles != NULL) {
+        for (int y = 0; y < result->h; y++) {
+            for (int x = 0; x < result->w; x++) {
+                putchar(TileChar(pending->tiles[x + y * result->w]));
+            }
+            putchar('\n');
+        }
+    }
+}
+
+int RunInteractive(struct Host* host) {
+    char line[256];
+    char word[32];
+    char arg[32];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        struct Pending pending;
+        struct HostCallback callback = {PendingDone, &pending};
+        atomic_init(&pending.done, 0);
+        pending.tiles = NULL;
+
+        int id, tile, w, h, bombs;
+        unsigned long long seed = (unsigned long long)time(NULL);
+        int status = HOST_ERROR;
+        int show = 0;
+
+        if (sscanf(line, "%31s", word) != 1) {
+            continue;
+        }
+
+        if (strcmp(word, "quit") == 0) {
+            break;
+        } else if (strcmp(word, "stats") == 0) {
+            struct HostStats stats;
+            HostGetStats(host, &stats);
+            PrintStats(&stats, 0, 0, 0);
+            continue;
+        } else if (strcmp(word, "open") == 0 && sscanf(line, "%*s %d %d %d %llu", &w, &h, &bombs, &seed) >= 3) {
+            status = HostOpenSession(host, w, h, bombs, seed, callback);
+        } else if (strcmp(word, "open") == 0 && sscanf(line, "%*s %31s %llu", arg, &seed) >= 1) {
+            struct Setting setting;
+            if (ParseSetting(arg, &setting)) {
+                status = HostOpenSession(host, setting.w, setting.h, setting.bombCount, seed, callback);
+            }
+        } else if (strcmp(word, "reveal") == 0 && sscanf(line, "%*s %d %d", &id, &tile) == 2) {
+            status = HostSubmit(host, id, HOST_REVEAL, tile, callback);
+        } else if (strcmp(word, "flag") == 0 && sscanf(line, "%*s %d %d", &id, &tile) == 2) {
+            status = HostSubmit(host, id, HOST_FLAG, tile, callback);
+        } else if ((strcmp(word, "state") == 0 || strcmp(word, "show") == 0) && sscanf(line, "%*s %d", &id) == 1) {
+            show = strcmp(word, "show") == 0;
+            status = HostSubmit(host, id, HOST_STATE, 0, callback);
+        } else if (strcmp(word, "close") == 0 && sscanf(line, "%*s %d", &id) == 1) {
+            status = HostSubmit(host, id, HOST_CLOSE, 0, callback);
+        }
+
+        if (status < 0) {
+            printf("error %d\n", status);
+        } else {
+            WaitPending(&pending);
+            PrintReply(&pending, show);
+            free(pending.tiles);
+        }
+        fflush(stdout);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------
+// Load generator
+//----------------------------------------------------------------------------------
+unsigned int AgentRandom(struct Agent* agent) {
+    agent->rngState = agent->rngState * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned int)(agent->rngState >> 33);
+}
+
+void AgentDone(void* user, const struct HostResult* result);
+
+// A random tile that is still hidden
+int AgentPickTile(struct Agent* agent, const struct HostResult* result) {
+    int len = result->w * result->h;
+    int tile = (int)(AgentRandom(agent) % (unsigned int)len);
+    for (int i = 0; i < len && result->tiles[tile] != UNREVEALED; i++) {
+        tile = (tile + 1) % len;
+    }
+    return tile;
+}
+
+// Callback of a --verify command: check it completes in order and alone, and send the next batch after the last one.
+void VerifyDone(void* user, const struct HostResult* result) {
+    struct Ticket* ticket = user;
+    struct Agent* agent = ticket->agent;
+
+    if (atomic_exchange(&agent->inCallback, 1) != 0) {
+        atomic_fetch_add(&overlaps, 1);
+    }
+    if (ticket->seq != agent->done) {
+        atomic_fetch_add(&outOfOrder, 1);
+    }
+    atomic_fetch_add_explicit(&verifiedCommands, 1, memory_order_relaxed);
+    agent->done = ticket->seq + 1;
+    int last = agent->done == agent->sent;
+    atomic_store(&agent->inCallback, 0);
+
+    // Cleared first: the next game is opened in another slot, its callbacks may run anywhere
+    if (last) {
+        AgentDone(agent, result);
+    } else if (result->status != HOST_OK) {
+        agent->failed = 1;
+    }
+}
+
+// Send VERIFY_BATCH commands at once. They're all numbered before the first one goes out.
+void AgentSendBatch(struct Agent* agent, const struct HostResult* result) {
+    int tiles[VERIFY_BATCH];
+    int commands[VERIFY_BATCH];
+    for (int i = 0; i < VERIFY_BATCH; i++) {
+        agent->tickets[i].agent = agent;
+        agent->tickets[i].seq = agent->sent + i;
+        tiles[i] = AgentPickTile(agent, result);
+        commands[i] = AgentRandom(agent) % 4 == 0 ? HOST_STATE : HOST_REVEAL;
+    }
+    agent->sent += VERIFY_BATCH;
+
+    for (int i = 0; i < VERIFY_BATCH; i++) {
+        struct HostCallback callback = {VerifyDone, &agent->tickets[i]};
+        if (HostSubmit(agent->host, result->session, commands[i], tiles[i], callback) != HOST_OK) {
+            agent->failed = 1;
+            return;
+        }
+    }
+}
+
+void AgentOpen(struct Agent* agent) {
+    struct HostCallback callback = {AgentDone, agent};
+    unsigned long long seed = ((unsigned long long)AgentRandom(agent) << 32) | AgentRandom(agent);
+    if (HostOpenSession(agent->host, agent->setting.w, agent->setting.h, agent->setting.bombCount, seed, callback) < 0) {
+        agent->failed = 1;
+    }
+}
+
+// Called on a worker when the agent's last command is done: play on, or start a new game.
+void AgentDone(void* user, const struct HostResult* result) {
+    struct Agent* agent = user;
+    struct HostCallback callback = {AgentDone, agent};
+
+    if (atomic_load_explicit(&stopping, memory_order_relaxed)) {
+        return;
+    }
+    if (result->status != HOST_OK) {
+        agent->failed = 1;
+        return;
+    }
+
+    if (result->command == HOST_CLOSE) {
+        AgentOpen(agent);
+        if (agent->verify) {
+            // The new session waits in this worker's deque. Hold the worker up so another one steals it.
+            struct timespec wait = {0, 50000};
+            nanosleep(&wait, NULL);
+        }
+        return;
+    }
+
+    if (result->stage == SESSION_LOST || result->stage == SESSION_WON) {
+        HostSubmit(agent->host, result->session, HOST_CLOSE, 0, callback);
+        return;
+    }
+
+    if (agent->verify) {
+        AgentSendBatch(agent, result);
+        return;
+    }
+
+    // Click a random tile that is still hidden, flag one now and then
+    int tile = AgentPickTile(agent, result);
+    int command = (AgentRandom(agent) % 16 == 0 && result->stage == SESSION_STARTED) ? HOST_FLAG : HOST_REVEAL;
+    HostSubmit(agent->host, result->session, command, tile, callback);
+}
+
+int RunBench(struct Host* host, int agentCount, double seconds, struct Setting setting, unsigned long long seed, int verify) {
+    struct Agent* agents = calloc(agentCount, sizeof(struct Agent));
+    if (agents == NULL) {
+        return 1;
+    }
+
+    for (int i = 0; i < agentCount; i++) {
+        agents[i].host = host;
+        agents[i].setting = setting;
+        agents[i].rngState = seed + 0x9E3779B97F4A7C15ULL * (i + 1);
+        agents[i].verify = verify;
+        atomic_init(&agents[i].inCallback, 0);
+        AgentOpen(&agents[i]);
+    }
+
+    // Skip the first second, sessions are still being opened
+    struct timespec second = {1, 0};
+    nanosleep(&second, NULL);
+    HostResetLatency(host);
+
+    struct HostStats stats;
+    HostGetStats(host, &stats);
+    double start = NowSeconds();
+    double last = start;
+    long long startFinished = stats.gamesFinished;
+    long long startCommands = stats.commands;
+    long long lastFinished = startFinished;
+    long long lastCommands = startCommands;
+
+    while (NowSeconds() - start < seconds) {
+        nanosleep(&second, NULL);
+        double now = NowSeconds();
+        HostGetStats(host, &stats);
+        fprintf(stderr, "%.0fs: %.0f sessions/s, %.0f commands/s, p99 %.1fus\n", now - start,
+                (stats.gamesFinished - lastFinished) / (now - last), (stats.commands - lastCommands) / (now - last), stats.p99Ns / 1000.0);
+        last = now;
+        lastFinished = stats.gamesFinished;
+        lastCommands = stats.commands;
+    }
+
+    HostGetStats(host, &stats);
+    double elapsed = NowSeconds() - start;
+    atomic_store(&stopping, 1);
+    PrintStats(&stats, elapsed, stats.gamesFinished - startFinished, stats.commands - startCommands);
+
+    int failed = 0;
+    for (int i = 0; i < agentCount; i++) {
+        failed += agents[i].failed;
+    }
+    if (failed > 0) {
+        fprintf(stderr, "%d sessions failed\n", failed);
+    }
+
+    // Workers still hold pointers to the agents until they stop
+    HostDestroy(host);
+    free(agents);
+
+    if (verify) {
+        long long commands = atomic_load(&verifiedCommands);
+        long long misordered = atomic_load(&outOfOrder);
+        long long overlapped = atomic_load(&overlaps);
+        fprintf(stderr, "verify: %lld commands, %lld out of order, %lld overlapping callbacks\n", commands, misordered, overlapped);
+        if (commands == 0 || misordered > 0 || overlapped > 0) {
+            return 1;
+        }
+    }
+    return failed > 0;
+}
+
+//----------------------------------------------------------------------------------
+// Main Entry Point
+//----------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int maxSessions = 0;
+    int bench = 0;
+    int verify = 0;
+    int agentCount = 4096;
+    double seconds = 10;
+    unsigned long long seed = 1;
+    struct Setting setting;
+
+    InitDifficulty();
+    setting = medium;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-sessions") == 0 && i + 1 < argc) {
+            maxSessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            agentCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--setting") == 0 && i + 1 < argc && ParseSetting(argv[i + 1], &setting)) {
+            ++i;
+        } else {
+            fprintf(stderr, "usage: %s [--threads N] [--max-sessions N] [--bench [--verify] [--sessions N] [--seconds N] [--seed N] [--setting easy|medium|hard|WxH:M]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (threads < 1) threads = 1;
+    if (agentCount < 1) agentCount = 1;
+    if (maxSessions < 1) {
+        // Closed sessions are reopened in a new slot, leave room for both
+        maxSessions = bench ? 2 * agentCount : 4096;
+    }
+
+    struct Host* host = HostCreate(threads, maxSessions);
+    if (host == NULL) {
+        fprintf(stderr, "failed to start host (at most %d sessions)\n", HOST_MAX_SESSIONS);
+        return 1;
+    }
+
+    if (bench) {
+        return RunBench(host, agentCount, seconds, setting, seed, verify);
+    }
+
+    int result = RunInteractive(host);
+    HostDestroy(host);
+    return result;
+}
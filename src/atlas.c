@@ -0,0 +1,89 @@
+#include "atlas.h"
+
+// Pack images into one texture with a shelf packer: tallest first, left to right, a new row when
+// the current one is full. The images are copied, the caller still owns them.
+// Returns 1 on success, the rectangles are in ap->recs in the same order as images.
+int BuildAtlas(struct Atlas* ap, Image* images, int count, int padding) {
+    if (count < 1 || count > ATLAS_MAX_IMAGES) {
+        return 0;
+    }
+
+    int order[ATLAS_MAX_IMAGES];
+    int maxWidth = 0;
+    int area = 0;
+
+    for (int i = 0; i < count; i++) {
+        // Insertion sort by height, tallest first
+        int j = i;
+        while (j > 0 && images[order[j - 1]].height < images[i].height) {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = i;
+
+        if (images[i].width > maxWidth) {
+            maxWidth = images[i].width;
+        }
+        area += (images[i].width + padding) * (images[i].height + padding);
+    }
+
+    int width = 64;
+    while (width < maxWidth + 2 * padding || width * width < area) {
+        width *= 2;
+    }
+
+    int x = padding;
+    int y = padding;
+    int rowHeight = 0;
+
+    for (int i = 0; i < count; i++) {
+        Image* image = &images[order[i]];
+        if (x + image->width + padding > width) {
+            x = padding;
+            y += rowHeight + padding;
+            rowHeight = 0;
+        }
+        ap->recs[order[i]] = (Rectangle){x, y, image->width, image->height};
+        x += image->width + padding;
+        if (image->height > rowHeight) {
+            rowHeight = image->height;
+        }
+    }
+
+    // Power of two height as well, GLES2 can't repeat other sizes
+    int height = 64;
+    while (height < y + rowHeight + padding) {
+        height *= 2;
+    }
+
+    Image atlasImage = GenImageColor(width, height, BLANK);
+    for (int i = 0; i < count; i++) {
+        ImageDraw(&atlasImage, images[i], (Rectangle){0, 0, images[i].width, images[i].height}, ap->recs[i], WHITE);
+    }
+
+    ap->texture = LoadTextureFromImage(atlasImage);
+    ap->count = count;
+    UnloadImage(atlasImage);
+
+    return IsTextureValid(ap->texture);
+}
+
+void UnloadAtlas(struct Atlas* ap) {
+    UnloadTexture(ap->texture);
+    ap->count = 0;
+}
+
+// Turn a rectangle inside image into the same rectangle inside the atlas.
+Rectangle AtlasRec(struct Atlas* ap, int image, Rectangle rec) {
+    return (Rectangle){ap->recs[image].x + rec.x, ap->recs[image].y + rec.y, rec.width, rec.height};
+}
+
+// Point a font at its glyphs in the atlas. image must be the font's own texture, see LoadImageFromTexture.
+// The font's old texture is unloaded.
+void AtlasFont(struct Atlas* ap, int image, Font* font) {
+    UnloadTexture(font->texture);
+    font->texture = ap->texture;
+    for (int i = 0; i < font->glyphCount; i++) {
+        font->recs[i] = AtlasRec(ap, image, font->recs[i]);
+    }
+}
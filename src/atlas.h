@@ -0,0 +1,23 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "raylib.h"
+
+#define ATLAS_MAX_IMAGES 32
+
+// Several images packed into one texture, so everything drawn from it shares one draw batch.
+struct Atlas {
+    Texture2D texture;
+    int count;
+    Rectangle recs[ATLAS_MAX_IMAGES]; //Where image i ended up in the texture
+};
+
+//----------------------------------------------------------------------------------
+// Atlas Functions Declaration
+//----------------------------------------------------------------------------------
+int BuildAtlas(struct Atlas* ap, Image* images, int count, int padding);
+void UnloadAtlas(struct Atlas* ap);
+Rectangle AtlasRec(struct Atlas* ap, int image, Rectangle rec);
+void AtlasFont(struct Atlas* ap, int image, Font* font);
+
+#endif
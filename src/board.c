@@ -0,0 +1,396 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+
+// Difficulty settings
+struct Setting easy;
+struct Setting medium;
+struct Setting hard;
+
+// Called at the start to initialise difficulty structs.
+void InitDifficulty(void) {
+    //set difficulties
+    easy.h = 8;
+    easy.w = 12;
+    easy.bombCount = 20;
+    easy.difficulty = 0;
+
+    medium.h = 12;
+    medium.w = 16;
+    medium.bombCount = 36;
+    medium.difficulty = 1;
+
+    hard.h = 16;
+    hard.w = 24;
+    hard.bombCount = 80;
+    hard.difficulty = 2;
+}
+
+// Read a setting from the command line: easy, medium, hard or WxH:M. Returns 0 if it isn't one,
+// if the board is bigger than BOARD_MAX_TILES or if the mines don't leave room for the first click's 3x3.
+int ParseSetting(const char* arg, struct Setting* setting) {
+    if (strcmp(arg, "easy") == 0) {
+        *setting = easy;
+    } else if (strcmp(arg, "medium") == 0) {
+        *setting = medium;
+    } else if (strcmp(arg, "hard") == 0) {
+        *setting = hard;
+    } else if (sscanf(arg, "%dx%d:%d", &setting->w, &setting->h, &setting->bombCount) == 3) {
+        setting->difficulty = 3;
+    } else {
+        return 0;
+    }
+    long long len = (long long)setting->w * setting->h;
+    return setting->w > 0 && setting->h > 0 && len <= BOARD_MAX_TILES && setting->bombCount >= 0 && setting->bombCount <= len - 9;
+}
+
+// Give a grid its own buffers for a w x h board and InitMap it, for code that doesn't own fixed arrays
+// like the game does. Returns 0 if out of memory or w * h doesn't fit an int; FreeGrid is safe either way.
+int AllocGrid(struct Grid* gp, int w, int h, int bombCount) {
+    memset(gp, 0, sizeof(*gp));
+    size_t len = (size_t)w * (size_t)h;
+    if (w < 1 || h < 1 || len > INT_MAX) {
+        return 0;
+    }
+    gp->w = w;
+    gp->h = h;
+    gp->len = (int)len;
+    gp->bombCount = bombCount;
+    gp->tiles = malloc(len);
+    gp->map = malloc(len);
+    gp->tilesScanned = malloc(sizeof(int) * len);
+    gp->scanQue = malloc(sizeof(int) * len);
+    if (gp->tiles == NULL || gp->map == NULL || gp->tilesScanned == NULL || gp->scanQue == NULL) {
+        return 0;
+    }
+    InitMap(gp);
+    return 1;
+}
+
+void FreeGrid(struct Grid* gp) {
+    free(gp->tiles);
+    free(gp->map);
+    free(gp->tilesScanned);
+    free(gp->scanQue);
+    gp->tiles = NULL;
+    gp->map = NULL;
+    gp->tilesScanned = NULL;
+    gp->scanQue = NULL;
+}
+
+// Clear the player's view of the board, keeping the map.
+void ResetTiles(struct Grid* gp) {
+    memset(gp->tiles, UNREVEALED, gp->len);
+    for (int i = 0; i < gp->len; i++) {
+        gp->tilesScanned[i] = -1;
+    }
+    gp->tilesRevealed = 0;
+    gp->flagCount = 0;
+    gp->bombsFlagged = 0;
+}
+
+// Seed the grid's own random state. Every grid can be shuffled independently, from any thread.
+void SeedMap(struct Grid* gp, unsigned long long seed) {
+    gp->rngState = seed;
+}
+
+// Seed the grid for board number board of a run started from seed. Every board gets its own stream,
+// so the tools deal the same boards whatever thread or batch a board lands in.
+void SeedBoard(struct Grid* gp, unsigned long long seed, long long board) {
+    SeedMap(gp, seed ^ ((unsigned long long)(board + 1) * 0xD1B54A32D192ED03ULL));
+}
+
+// Next 32 random bits (splitmix64)
+unsigned int MapRandom(struct Grid* gp) {
+    unsigned long long z = (gp->rngState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+// A random tile of the grid, e.g. a first click
+int RandomTile(struct Grid* gp) {
+    return (int)(((unsigned long long)MapRandom(gp) * (unsigned int)gp->len) >> 32);
+}
+
+// Initialise/Reset the map. Uses the h, w, len and bombCount already set on the grid.
+void InitMap(struct Grid* gp) {
+
+    //printf("InitMap ran\n");
+
+    //bomb gen
+    //gp->bombCount = (int)(2.35 * sqrt(gp->len));
+    //gp->bombCount = 5;
+
+    gp->bombsFlagged = 0;
+    gp->flagCount = 0;
+    gp->tilesRevealed = 0;
+    gp->genPos = 0;
+
+    for (int i = 0; i < gp->len; i++) {
+        gp->tiles[i] = UNREVEALED;
+        gp->map[i] = REVEALED;
+        gp->scanQue[i] = -1;
+        gp->tilesScanned[i] = -1;
+
+    }
+
+    for (int i = 0; i < gp->bombCount; i++) {
+        gp->map[i] = BOMB;
+    }
+}
+
+// Shuffle the map after user clicks the first tile. The initial 3x3 tiles the user clicks are always 0.
+// The bombs are shuffled over the tiles outside the 3x3 area only, then spread back over the whole map.
+void ShuffleMap(struct Grid* gp, int tileRevealed) {
+
+    //printf("ShuffleMap ran\n");
+
+    int tileX = tileRevealed % gp->w;
+    int tileY = tileRevealed / gp->w;
+
+    int safeCount = 0;
+    for (int i = 0; i < 9; i++) {
+        if (XYInBounds(gp, tileX - 1 + (i % 3), tileY - 1 + (i / 3)) == 1) {
+            ++safeCount;
+        }
+    }
+
+    int shuffleLen = gp->len - safeCount;
+
+    for (int i = 0; i < shuffleLen; i++) {
+        gp->map[i] = (i < gp->bombCount) ? BOMB : REVEALED;
+    }
+
+    // Fisher-Yates. Multiply and shift maps 32 random bits onto 0..i without a division.
+    for (int i = shuffleLen - 1; i > 0; i--) {
+        int r = (int)(((unsigned long long)MapRandom(gp) * (unsigned int)(i + 1)) >> 32);
+        char t = gp->map[r];
+        gp->map[r] = gp->map[i];
+        gp->map[i] = t;
+    }
+
+    // Walk backwards so map[j] is always read before tile j is overwritten.
+    int j = shuffleLen - 1;
+    for (int y = gp->h - 1; y >= 0; y--) {
+        for (int x = gp->w - 1; x >= 0; x--) {
+            int i = x + y * gp->w;
+            if (abs(x - tileX) <= 1 && abs(y - tileY) <= 1) {
+                gp->map[i] = REVEALED;
+            } else {
+                gp->map[i] = gp->map[j--];
+            }
+        }
+    }
+
+    gp->genPos = 0;
+}
+
+// Fill the map array with number tiles according to the bombs.
+void GenMap(struct Grid* gp) {
+    gp->genPos = 0;
+    GenMapStep(gp, gp->len);
+}
+
+// Number the next count tiles of the map, so a big board can be generated over several frames.
+// Returns 1 once the whole map is done. Tiles revealed before that are numbered by RevealTile.
+int GenMapStep(struct Grid* gp, int count) {
+    int end = (count < gp->len - gp->genPos) ? gp->genPos + count : gp->len;
+    for (int i = gp->genPos; i < end; i++) {
+        GenTile(gp, i);
+    }
+    gp->genPos = end;
+    return gp->genPos == gp->len;
+}
+
+// Give one tile its number. Doing it twice is harmless, only the bombs are looked at.
+void GenTile(struct Grid* gp, int tile) {
+    if (gp->map[tile] != BOMB) {
+        int bombCount = GetSurroundingBombCount(gp, tile);
+        if (bombCount != 0) {
+            gp->map[tile] = NUM_TILE(bombCount);
+        }
+    }
+}
+
+// Convert a pixel on the map to the tile it corresponds to
+int PixelToGrid(struct Grid* gp, Vector2 origin, Vector2 mousePos, int tileLen) {
+
+    Vector2 pos = {mousePos.x - origin.x, mousePos.y - origin.y};
+
+    if (pos.x < 0 || pos.y < 0) {
+        return -1;
+    }
+
+    int gridX = pos.x / tileLen;
+    int gridY = pos.y / tileLen;
+
+    if (gridX >= gp->w || gridY >= gp->h) {
+        return -1;
+    }
+
+    return gridX + gridY * gp->w;
+}
+
+// Check if a given tile index is within the len of the map.
+int TileInBounds(struct Grid* gp, int tile) {
+    /*
+    int tileX = tile % gp->w;
+    int tileY = tile / gp->w;
+
+    return XYInBounds(gp, tileX, tileY);
+    */
+    if (tile >= 0 && tile < gp->len) {
+        return 1;
+    }
+    return 0;
+}
+
+// Check if given x and y are withing the grid.
+int XYInBounds(struct Grid* gp, int tileX, int tileY) {
+
+    if (tileX >= 0 && tileY >= 0 && tileX < gp->w && tileY < gp->h) {
+        return 1;
+    }
+    return 0;
+}
+
+// Function to get address and values of surrounding tiles
+int GetSurroundingTiles(struct Grid* gp, int tile, int* surroundingTileAddresses, char* surroundingTiles) {
+    int tileX = tile % gp->w;
+    int tileY = tile / gp->w;
+
+    //printf("fetched surr. tiles. pos x:%d, y:%d\n", tileX, tileY);
+    int x, y;
+    int pos;
+
+    int bombCount = 0;
+
+    for (int i = 0; i < 9; i++) {
+        x = -1 + (i % 3);
+        y = -1 + (i / 3);
+        if (XYInBounds(gp, tileX + x, tileY + y) == 1) {
+            //gp->tiles[tile + x + (y * gp->w)] = FLAG; // DEBUG
+            pos = tile + x + (y * gp->w);
+            *(surroundingTileAddresses++) = pos;
+            *(surroundingTiles++) = gp->map[pos];
+            if (gp->map[pos] == BOMB) {
+                ++bombCount;
+            }
+        } else {
+            *(surroundingTileAddresses++) = -1;
+            *(surroundingTiles++) = -1;
+        }
+    }
+
+    return bombCount;
+}
+
+// Function to return # of bombs surrounding tile
+int GetSurroundingBombCount(struct Grid* gp, int tile) {
+    int tileX = tile % gp->w;
+    int tileY = tile / gp->w;
+
+    //printf("pos x:%d, y:%d\n", tileX, tileY);
+    int x, y;
+    int pos;
+
+    int bombCount = 0;
+
+    for (int i = 0; i < 9; i++) {
+        x = -1 + (i % 3);
+        y = -1 + (i / 3);
+        if (XYInBounds(gp, tileX + x, tileY + y) == 1) {
+            pos = tile + x + (y * gp->w);
+            if (gp->map[pos] == BOMB) {
+                ++bombCount;
+            }
+        }
+    }
+
+    return bombCount;
+}
+
+// Write a tile, recording the change if the grid has a journal
+void SetTile(struct Grid* gp, int tile, char value) {
+    if (gp->journal != NULL) {
+        JournalRecord(gp->journal, tile, gp->tiles[tile], value);
+    }
+    gp->tiles[tile] = value;
+}
+
+// Function to reveal a tile. Checks if new tile is bomb/not
+int RevealTile(struct Grid* gp, int gridPos) {
+    if (gp->tiles[gridPos] == UNREVEALED) {
+        if (gp->genPos < gp->len) {
+            GenTile(gp, gridPos);
+        }
+        if (gp->map[gridPos] == BOMB) {
+            return -1;
+        } else {
+            SetTile(gp, gridPos, gp->map[gridPos]);
+            gp->tilesRevealed += 1;
+            return 1;
+        }
+
+    }
+    return 0;
+}
+
+// Function to flag/un-flag a tile
+void FlagTile(struct Grid* gp, int gridPos) {
+    if (gp->tiles[gridPos] == FLAG) {
+        SetTile(gp, gridPos, UNREVEALED);
+        gp->flagCount -= 1;
+        if (gp->map[gridPos] == BOMB) {
+            gp->bombsFlagged -= 1;
+        }
+    }
+    else if (gp->tiles[gridPos] == UNREVEALED) {
+        SetTile(gp, gridPos, FLAG);
+        gp->flagCount += 1;
+        if (gp->map[gridPos] == BOMB) {
+            gp->bombsFlagged += 1;
+        }
+    }
+}
+
+// Called when user reveals 0 tile to reveal all surrounding non-bomb tiles.
+// Breadth first flood fill. Every tile is queued at most once per call, so scanQue needs len entries.
+// Afterwards scanQue[0..quePos) lists every tile the flood looked at.
+void RevealEmptyTiles(struct Grid* gp, int gridPos) {
+
+    int surroundingTileAddresses[9];
+    char surroundingTiles[9];
+
+    int queLen = 1;
+
+    gp->quePos = 0;
+    gp->scanQue[0] = gridPos;
+    gp->tilesScanned[gridPos] = gridPos;
+
+    while (gp->quePos < queLen) {
+        int adjacentBombCount = GetSurroundingTiles(gp, gp->scanQue[gp->quePos++], &surroundingTileAddresses[0], &surroundingTiles[0]);
+        if (adjacentBombCount == 0) {
+            for (int j = 0; j < 9; j++) {
+                int scanPos = surroundingTileAddresses[j];
+                if (scanPos != -1 && gp->tilesScanned[scanPos] != gridPos) {
+                    gp->tilesScanned[scanPos] = gridPos;
+                    gp->scanQue[queLen++] = scanPos;
+
+                    RevealTile(gp, scanPos);
+
+                    //printf("tile revealed. x: %d y: %d\n", scanPos % gp->w, scanPos / gp->w);
+                }
+            }
+        }
+    }
+
+    // Clear the marks, undo can hide these tiles again and the next flood from gridPos must see them
+    for (int i = 0; i < queLen; i++) {
+        gp->tilesScanned[gp->scanQue[i]] = -1;
+    }
+}
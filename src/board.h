@@ -0,0 +1,71 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "raylib.h"
+
+#include "journal.h"
+
+#define UNGENERATED (-1)
+#define UNREVEALED 0
+#define REVEALED 1
+#define FLAG 2
+#define QUESTION_UNREVEALED 3
+#define QUESTION_REVEALED 4
+#define BOMB 5
+#define BOMB_RED 6
+#define BOMB_CROSS 7
+#define NUM_TILE(num) (7 + num)
+
+#define BOARD_MAX_TILES (1 << 24) //Largest w * h ParseSetting accepts, keeps tile counts and buffer sizes in int
+
+struct Grid {
+    int h, w, len; //height, width, length
+    char* tiles; //Tiles to be rendered
+    char* map; //Map of numbers and bombs
+    int* tilesScanned; //Array to help with tile scanning/revealing
+    int* scanQue;
+    int quePos;
+    int genPos; //Tiles before genPos have their numbers in map, see GenMapStep
+    int bombCount, bombsFlagged, flagCount, tilesRevealed;
+    unsigned long long rngState; //Random state used by ShuffleMap, see SeedMap
+    struct Journal* journal; //Records tile changes for undo/redo, NULL when not in use
+};
+
+struct Setting {
+    int h, w, bombCount;
+    char difficulty;
+};
+
+// Difficulty settings
+extern struct Setting easy;
+extern struct Setting medium;
+extern struct Setting hard;
+
+//----------------------------------------------------------------------------------
+// Board Functions Declaration
+//----------------------------------------------------------------------------------
+void InitDifficulty(void);
+int ParseSetting(const char* arg, struct Setting* setting);
+int AllocGrid(struct Grid* gp, int w, int h, int bombCount);
+void FreeGrid(struct Grid* gp);
+void ResetTiles(struct Grid* gp);
+void SeedMap(struct Grid* gp, unsigned long long seed);
+void SeedBoard(struct Grid* gp, unsigned long long seed, long long board);
+unsigned int MapRandom(struct Grid* gp);
+int RandomTile(struct Grid* gp);
+void InitMap(struct Grid* gp);
+void ShuffleMap(struct Grid* gp, int tileRevealed);
+void GenMap(struct Grid* gp);
+int GenMapStep(struct Grid* gp, int count);
+void GenTile(struct Grid* gp, int tile);
+int PixelToGrid(struct Grid* gp, Vector2 origin, Vector2 mousePos, int tileLen);
+int TileInBounds(struct Grid* gp, int tile);
+int XYInBounds(struct Grid* gp, int tileX, int tileY);
+int GetSurroundingTiles(struct Grid* gp, int tile, int* surroundingTileAddresses, char* surroundingTiles);
+int GetSurroundingBombCount(struct Grid* gp, int tile);
+void SetTile(struct Grid* gp, int tile, char value);
+int RevealTile(struct Grid* gp, int gridPos);
+void FlagTile(struct Grid* gp, int gridPos);
+void RevealEmptyTiles(struct Grid* gp, int gridPos);
+
+#endif
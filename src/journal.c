@@ -0,0 +1,169 @@
+#include <stdlib.h>
+
+#include "board.h"
+#include "journal.h"
+
+// Allocate the rings. Returns 0 if allocation failed.
+int JournalInit(struct Journal* jp, int entryCap, int changeCap) {
+    jp->entryCap = entryCap;
+    jp->changeCap = changeCap;
+    jp->entries = malloc(sizeof(struct JournalEntry) * entryCap);
+    jp->changes = malloc(sizeof(struct TileChange) * changeCap);
+
+    JournalClear(jp);
+
+    if (jp->entries == NULL || jp->changes == NULL) {
+        JournalFree(jp);
+        return 0;
+    }
+    return 1;
+}
+
+void JournalFree(struct Journal* jp) {
+    free(jp->entries);
+    free(jp->changes);
+    jp->entries = NULL;
+    jp->changes = NULL;
+    jp->entryCap = 0;
+    jp->changeCap = 0;
+}
+
+// Forget all moves. Called whenever the map is reset.
+void JournalClear(struct Journal* jp) {
+    jp->changeHead = 0;
+    jp->first = 0;
+    jp->cursor = 0;
+    jp->last = 0;
+    jp->recording = 0;
+    jp->overflow = 0;
+    jp->moveStart = 0;
+    jp->moveCount = 0;
+}
+
+// Start recording a move. Every tile write made by the board functions until JournalEnd belongs to it.
+void JournalBegin(struct Journal* jp, struct Grid* gp) {
+    if (jp->changeCap == 0 || jp->entryCap == 0) {
+        return;
+    }
+
+    jp->recording = 1;
+    jp->overflow = 0;
+    jp->moveCount = 0;
+
+    // Overwrite the redo history, it's dropped if the move changes anything
+    if (jp->cursor < jp->last) {
+        jp->moveStart = jp->entries[jp->cursor % jp->entryCap].start;
+    } else {
+        jp->moveStart = jp->changeHead;
+    }
+
+    jp->flagCount = gp->flagCount;
+    jp->bombsFlagged = gp->bombsFlagged;
+    jp->tilesRevealed = gp->tilesRevealed;
+}
+
+// Called by the board functions for every tile they change.
+void JournalRecord(struct Journal* jp, int tile, char before, char after) {
+    if (!jp->recording || jp->overflow) {
+        return;
+    }
+
+    if (jp->moveCount == jp->changeCap) {
+        jp->overflow = 1;
+        return;
+    }
+
+    struct TileChange* change = &jp->changes[(jp->moveStart + jp->moveCount) % jp->changeCap];
+    change->tile = tile;
+    change->before = before;
+    change->after = after;
+    ++jp->moveCount;
+}
+
+// Finish the move. Moves that changed nothing are not kept.
+void JournalEnd(struct Journal* jp, struct Grid* gp, int tag) {
+    if (!jp->recording) {
+        return;
+    }
+    jp->recording = 0;
+
+    // Move is bigger than the whole ring, and has overwritten everything else
+    if (jp->overflow) {
+        JournalClear(jp);
+        return;
+    }
+
+    if (jp->moveCount == 0) {
+        return;
+    }
+
+    jp->last = jp->cursor;
+    jp->changeHead = jp->moveStart + jp->moveCount;
+
+    if (jp->last - jp->first == jp->entryCap) {
+        ++jp->first;
+    }
+
+    struct JournalEntry* entry = &jp->entries[jp->last % jp->entryCap];
+    entry->start = jp->moveStart;
+    entry->count = jp->moveCount;
+    entry->flagDelta = gp->flagCount - jp->flagCount;
+    entry->bombsFlaggedDelta = gp->bombsFlagged - jp->bombsFlagged;
+    entry->tilesRevealedDelta = gp->tilesRevealed - jp->tilesRevealed;
+    entry->tag = tag;
+
+    jp->cursor = ++jp->last;
+
+    // Drop the oldest moves whose changes were overwritten
+    while (jp->first < jp->last && jp->entries[jp->first % jp->entryCap].start < jp->changeHead - jp->changeCap) {
+        ++jp->first;
+    }
+}
+
+int JournalCanUndo(struct Journal* jp) {
+    return jp->cursor > jp->first;
+}
+
+int JournalCanRedo(struct Journal* jp) {
+    return jp->cursor < jp->last;
+}
+
+// Undo the last move, restoring only the tiles it changed. Returns its tag, or -1 if there's nothing to undo.
+int JournalUndo(struct Journal* jp, struct Grid* gp) {
+    if (!JournalCanUndo(jp)) {
+        return -1;
+    }
+
+    struct JournalEntry* entry = &jp->entries[--jp->cursor % jp->entryCap];
+
+    for (int i = entry->count - 1; i >= 0; i--) {
+        struct TileChange* change = &jp->changes[(entry->start + i) % jp->changeCap];
+        gp->tiles[change->tile] = change->before;
+    }
+
+    gp->flagCount -= entry->flagDelta;
+    gp->bombsFlagged -= entry->bombsFlaggedDelta;
+    gp->tilesRevealed -= entry->tilesRevealedDelta;
+
+    return entry->tag;
+}
+
+// Redo the last undone move. Returns its tag, or -1 if there's nothing to redo.
+int JournalRedo(struct Journal* jp, struct Grid* gp) {
+    if (!JournalCanRedo(jp)) {
+        return -1;
+    }
+
+    struct JournalEntry* entry = &jp->entries[jp->cursor++ % jp->entryCap];
+
+    for (int i = 0; i < entry->count; i++) {
+        struct TileChange* change = &jp->changes[(entry->start + i) % jp->changeCap];
+        gp->tiles[change->tile] = change->after;
+    }
+
+    gp->flagCount += entry->flagDelta;
+    gp->bombsFlagged += entry->bombsFlaggedDelta;
+    gp->tilesRevealed += entry->tilesRevealedDelta;
+
+    return entry->tag;
+}
@@ -0,0 +1,53 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+struct Grid;
+
+// One tile of tiles[] that changed during a move.
+struct TileChange {
+    int tile;
+    char before, after;
+};
+
+// One move (reveal, flag, flood reveal, ...). Its changes live in the change ring from start to start + count.
+struct JournalEntry {
+    long long start;
+    int count;
+    int flagDelta, bombsFlaggedDelta, tilesRevealedDelta;
+    int tag; //Caller defined, returned by JournalUndo/JournalRedo
+};
+
+// Undo/redo history stored as two rings, so memory stays bounded no matter how long the game runs.
+// Entries are kept from first to last (absolute indices), cursor is the next entry to redo.
+// When the change ring wraps, the oldest moves are dropped.
+struct Journal {
+    struct TileChange* changes;
+    int changeCap;
+    long long changeHead; //Absolute index of the next change to write
+
+    struct JournalEntry* entries;
+    int entryCap;
+    long long first, cursor, last;
+
+    char recording;
+    char overflow;
+    long long moveStart; //Where the move being recorded writes its changes
+    int moveCount;
+    int flagCount, bombsFlagged, tilesRevealed; //Grid counters when the move began
+};
+
+//----------------------------------------------------------------------------------
+// Journal Functions Declaration
+//----------------------------------------------------------------------------------
+int JournalInit(struct Journal* jp, int entryCap, int changeCap);
+void JournalFree(struct Journal* jp);
+void JournalClear(struct Journal* jp);
+void JournalBegin(struct Journal* jp, struct Grid* gp);
+void JournalRecord(struct Journal* jp, int tile, char before, char after);
+void JournalEnd(struct Journal* jp, struct Grid* gp, int tag);
+int JournalCanUndo(struct Journal* jp);
+int JournalCanRedo(struct Journal* jp);
+int JournalUndo(struct Journal* jp, struct Grid* gp);
+int JournalRedo(struct Journal* jp, struct Grid* gp);
+
+#endif
@@ -10,17 +10,21 @@
 
 #include "raylib.h"
 #include "raymath.h"
-
-#define UNGENERATED (-1)
-#define UNREVEALED 0
-#define REVEALED 1
-#define FLAG 2
-#define QUESTION_UNREVEALED 3
-#define QUESTION_REVEALED 4
-#define BOMB 5
-#define BOMB_RED 6
-#define BOMB_CROSS 7
-#define NUM_TILE(num) (7 + num)
+#include "rlgl.h"
+
+#include "atlas.h"
+#include "board.h"
+#include "journal.h"
+#include "pack.h"
+
+#define MOVE_LOST 1 //Journal tag for the move that revealed a bomb
+#define THEME_COUNT 3 //Classic, dark and blue sprites
+#define RENDER_BENCH_WARMUP 10 //Frames drawn before timing each scenario
+#define RENDER_BENCH_BATCH_ELEMENTS (1 << 14) //Quads, enough for a whole hard frame in one batch
+#define RENDER_BENCH_CHANNEL_TOLERANCE 8 //Color difference allowed before a pixel counts as different
+#ifndef RENDER_BENCH_GOLDEN_DIR
+    #define RENDER_BENCH_GOLDEN_DIR "bench/golden" //CMake points this at the source tree
+#endif
 
 #if defined(PLATFORM_WEB)
     #include <emscripten/emscripten.h>
@@ -61,22 +65,9 @@ int tileLen;
 int textureCount = 16;
 
 Vector2 textureRect = {16, 16 };
-Rectangle sprites[16];
-
-struct Grid {
-    int h, w, len; //height, width, length
-    char* tiles; //Tiles to be rendered
-    char* map; //Map of numbers and bombs
-    int* tilesScanned; //Array to help with tile scanning/revealing
-    int* scanQue;
-    int quePos;
-    int bombCount, bombsFlagged, flagCount, tilesRevealed;
-};
-
-struct Setting {
-    int h, w, bombCount;
-    char difficulty;
-};
+Rectangle themeSprites[THEME_COUNT][16]; //Sprite rectangles in the atlas for every theme
+Rectangle* sprites; //Rectangles of the current theme
+int theme = 0;
 
 struct Text {
     char* text;
@@ -105,12 +96,18 @@ struct Grid grid;
 struct Hud hud;
 struct Menu menu;
 
-// Difficulty settings
-struct Setting easy;
-struct Setting medium;
-struct Setting hard;
+// Undo/redo history for practice mode
+struct Journal journal;
+int journalEntries = 4096; //Max moves kept
+int journalChanges = 1 << 16; //Max tile changes kept over all moves
+char practiceMode = 0;
+
+// Board pack given with --pack, START deals packBoard from it instead of a random board
+struct Pack pack;
+char packLoaded = 0;
+long long packBoard = -1; //Today's board unless --board is given
 
-Texture2D spriteSheet;
+struct Atlas atlas; //Sprite sheet themes, font and a white block for shapes in one texture, see InitAtlas
 
 int textureRows = 2;
 int textureColumns = 8;
@@ -122,10 +119,8 @@ int maxLen;
 
 //int bombCount = 40;
 
-int surroundingTileAddresses[9];
-char surroundingTiles[9];
-
-int scanSize = 5;
+double genBudget = 0.002; //Seconds per frame spent numbering the board after the first click
+int genSlice = 1024; //Tiles numbered between budget checks
 
 //UI STUFF
 Vector2 textLenEasy;
@@ -141,18 +136,9 @@ Vector2 textPosCustom;
 // Module Functions Declaration
 //----------------------------------------------------------------------------------
 void UpdateDrawFrame(void);     // Update and Draw one frame
+void DrawGame(void);
+int InitAtlas(void);
 char* GetResourcePath(void);
-void InitMap(struct Grid* gp);
-void ShuffleMap(struct Grid* gp, int tileRevealed);
-void GenMap(struct Grid* gp);
-int PixelToGrid(struct Grid* gp, Vector2 origin, Vector2 mousePos);
-int TileInBounds(struct Grid* gp, int tile);
-int XYInBounds(struct Grid* gp, int tileX, int tileY);
-int GetSurroundingTiles(struct Grid* gp, int tile, int* surroundingTileAddresses, char* surroundingTiles);
-int GetSurroundingBombCount(struct Grid* gp, int tile);
-int RevealTile(struct Grid* gp, int gridPos);
-void FlagTile(struct Grid* gp, int gridPos);
-void RevealEmptyTiles(struct Grid* gp, int gridPos);
 void InitUI(struct Hud* hudp, struct Menu* menup);
 int DrawUI(Vector2 mousePos, struct Hud* hudp, struct Menu* menup);
 void RecalculateTextSize(struct Text* textp);
@@ -161,25 +147,69 @@ Rectangle RectangleFromVector2(Vector2* pos, Vector2* size);
 void DrawTextFromStruct(struct Text* textp);
 void DrawTextFromStructColor(struct Text* textp, Color color);
 void LoseGame(struct Grid* gp, int gridPos);
-void InitDifficulty(void);
 char UpdateDifficulty(struct Grid* gp, struct Setting* setting);
+void LoadPackBoard(void);
+int RunRenderBench(int frames, const char* goldenDir, int updateGolden, double tolerance);
 
 
 //----------------------------------------------------------------------------------
 // Main Entry Point
 //----------------------------------------------------------------------------------
-int main() {
+int main(int argc, char** argv) {
+
+    // Usage: Minesweeper [--pack PATH [--board N]]
+    //                    [--render-bench [--frames N] [--golden DIR] [--update-golden] [--tolerance FRACTION]]
+    const char* packPath = NULL;
+    char renderBench = 0;
+    int benchFrames = 300;
+    const char* goldenDir = RENDER_BENCH_GOLDEN_DIR;
+    char updateGolden = 0;
+    double tolerance = 0.001; //Fraction of pixels allowed to differ from the golden image
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packPath = argv[++i];
+        } else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            packBoard = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--render-bench") == 0) {
+            renderBench = 1;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            benchFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            goldenDir = argv[++i];
+        } else if (strcmp(argv[i], "--update-golden") == 0) {
+            updateGolden = 1;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        }
+    }
+
+    if (renderBench) {
+        // Offscreen and on Mesa's software rasterizer unless told otherwise, so results compare across machines
+#if defined(_WIN32)
+        if (getenv("LIBGL_ALWAYS_SOFTWARE") == NULL) _putenv_s("LIBGL_ALWAYS_SOFTWARE", "1");
+#else
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+#endif
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        SetTraceLogLevel(LOG_WARNING);
+    }
 
     // Initialization
     //--------------------------------------------------------------------------------------
     InitWindow(screenWidth, screenHeight, "Minesweeper");
 
-    spriteSheet = LoadTexture("resources/spriteSheet.png");
-
     gameFont = LoadFont("resources/fonts/alpha_beta.png");
 
+    // Everything is drawn from the atlas, there is nothing to fall back to without it
+    if (!InitAtlas()) {
+        printf("can't build the texture atlas\n");
+        UnloadFont(gameFont);
+        CloseWindow();
+        return 1;
+    }
+
     //SetRandomSeed((unsigned int)time(NULL));
-    srand((unsigned int)time(NULL)); //Comment out for predictable/nonrandom maps
+    SeedMap(&grid, (unsigned long long)time(NULL)); //Comment out for predictable/nonrandom maps
 
     InitDifficulty();
 
@@ -187,13 +217,6 @@ int main() {
 
     maxLen = hard.h * hard.w;
 
-    for (int i = 0; i < textureCount; i++) {
-        sprites[i].x = ((int)(i % 8) * 16);
-        sprites[i].y = ((int)(i / 8) * 16);
-        sprites[i].height = textureSize;
-        sprites[i].width = textureSize;
-    }
-
     textureOrigin = (Vector2){textureSize / 2, textureSize / 2};
     tileLen = textureSize * 2;
     tileLenVec = (Vector2){tileLen, tileLen};
@@ -205,8 +228,8 @@ int main() {
 
     char tiles[maxLen];
     char map[maxLen];
-    int tilesScanned[scanSize*maxLen];
-    int scanQue[scanSize*maxLen];
+    int tilesScanned[maxLen];
+    int scanQue[maxLen];
 
     grid.tiles = &tiles[0];
     grid.map = &map[0];
@@ -214,32 +237,61 @@ int main() {
     grid.scanQue = &scanQue[0];
     grid.quePos = 0;
 
+    grid.h = h;
+    grid.w = w;
+    grid.len = len;
+
     InitMap(&grid);
 
+    JournalInit(&journal, journalEntries, journalChanges);
+
     difficulty = UpdateDifficulty(&grid, &medium);
 
     InitUI(&hud, &menu);
 
+    if (packPath != NULL) {
+        // The board has to fit the grid buffers and the screen, which are sized for hard
+        if (PackOpen(&pack, packPath) && pack.boardCount > 0 && pack.w <= hard.w && pack.h <= hard.h && pack.bombCount <= pack.w * pack.h - 1) {
+            packLoaded = 1;
+            if (packBoard < 0 || packBoard >= pack.boardCount) {
+                packBoard = (long long)(time(NULL) / 86400) % pack.boardCount;
+            }
+        } else {
+            printf("can't use board pack %s\n", packPath);
+            PackClose(&pack);
+        }
+    }
+
+
+    int result = 0;
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(UpdateDrawFrame, 0, 1);
 #else
-    SetTargetFPS(60);   // Set our game to run at 60 frames-per-second
-    //--------------------------------------------------------------------------------------
+    if (renderBench) {
+        result = RunRenderBench(benchFrames, goldenDir, updateGolden, tolerance);
+    } else {
+        SetTargetFPS(60);   // Set our game to run at 60 frames-per-second
+        //--------------------------------------------------------------------------------------
 
-    // Main game loop
-    while (!WindowShouldClose())    // Detect window close button or ESC key
-    {
-        UpdateDrawFrame();
+        // Main game loop
+        while (!WindowShouldClose())    // Detect window close button or ESC key
+        {
+            UpdateDrawFrame();
+        }
     }
 #endif
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    JournalFree(&journal);
+    PackClose(&pack);
+    UnloadAtlas(&atlas);
+
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
-    return 0;
+    return result;
 }
 
 
@@ -249,63 +301,79 @@ void UpdateDrawFrame(void) {
     mousePos = GetMousePosition();
 
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-        int gridPos = PixelToGrid(&grid, startPos, Vector2Add(mousePos, (Vector2){6, 6}));
+        int gridPos = PixelToGrid(&grid, startPos, Vector2Add(mousePos, (Vector2){6, 6}), tileLen);
         //printf("gridPos: %d\n", gridPos);
 
         if (gameStage == 0 && gridPos != -1) {
             gameStage = 1;
-            ShuffleMap(&grid, gridPos);
-            GenMap(&grid);
+            ShuffleMap(&grid, gridPos); //Numbers are filled in below, a slice per frame
         }
         else if (gameStage == 1) {
 
         }
 
-        if (gameStage == 1 || gameStage == 0) {
+        if ((gameStage == 1 || gameStage == 0) && gridPos != -1) {
+            JournalBegin(&journal, &grid);
             int revealed = RevealTile(&grid, gridPos);
             if (revealed == 1 && grid.map[gridPos] == REVEALED) {
                 RevealEmptyTiles(&grid, gridPos);
             } else if (revealed == -1) {
                 LoseGame(&grid, gridPos);
             }
+            JournalEnd(&journal, &grid, revealed == -1 ? MOVE_LOST : 0);
         }
     }
 
     if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
-        int gridPos = PixelToGrid(&grid, startPos, Vector2Add(mousePos, (Vector2){6, 6}));
-        FlagTile(&grid, gridPos);
+        int gridPos = PixelToGrid(&grid, startPos, Vector2Add(mousePos, (Vector2){6, 6}), tileLen);
+        if (gridPos != -1) {
+            JournalBegin(&journal, &grid);
+            FlagTile(&grid, gridPos);
+            JournalEnd(&journal, &grid, 0);
+        }
     }
 
-    if (grid.len - grid.bombCount < grid.tilesRevealed && grid.bombCount == grid.bombsFlagged) {
-        gameStage = 3;
+    if (IsKeyPressed(KEY_P)) {
+        practiceMode = !practiceMode;
+        grid.journal = practiceMode ? &journal : NULL;
+        JournalClear(&journal);
     }
 
-    // Draw
-    //----------------------------------------------------------------------------------
-    BeginDrawing();
+    if (IsKeyPressed(KEY_T)) {
+        theme = (theme + 1) % THEME_COUNT;
+        sprites = themeSprites[theme];
+    }
 
-        ClearBackground(RAYWHITE);
+    if (practiceMode && gameStage != 2 && IsKeyPressed(KEY_Z)) {
+        if (JournalUndo(&journal, &grid) != -1 && (gameStage == -1 || gameStage == 3)) {
+            gameStage = 1;
+        }
+    }
 
-        //Draw hud and get cursor overlap
-        buttonSelected = DrawUI(mousePos, &hud, &menu);
-        //buttonSelected = 0;
+    if (practiceMode && gameStage != 2 && IsKeyPressed(KEY_Y)) {
+        if (JournalRedo(&journal, &grid) == MOVE_LOST) {
+            gameStage = -1;
+        }
+    }
 
-        if (gameStage != 2) { //Game
+    // Number the rest of the board within the frame budget. Tiles revealed before that get their number on the spot.
+    if (gameStage != 0 && gameStage != 2 && grid.genPos < grid.len) {
+        double genEnd = GetTime() + genBudget;
+        while (!GenMapStep(&grid, genSlice) && GetTime() < genEnd) {
 
-            //Rectangle around game field
-            DrawRectangle((int)startPos.x - 14, (int)startPos.y - 14, (int)gameSize.x + 14, (int)gameSize.y + 14, LIGHTGRAY);
+        }
+    }
 
-            // Bottom/Right line around game field
-            DrawRectangle((int)startPos.x - 8, (int)startPos.y - 8, (int)gameSize.x + 2, (int)gameSize.y + 2, BGGRAY);
+    if (grid.len - grid.bombCount < grid.tilesRevealed && grid.bombCount == grid.bombsFlagged) {
+        gameStage = 3;
+    }
 
-            //Render grid
-            for (int i = 0; i < grid.len; i++) {
-                DrawTexturePro(spriteSheet, sprites[grid.tiles[i]], (Rectangle){(i % grid.w) * tileLen + startPos.x, (int)(i / grid.w) * tileLen + startPos.y, tileLen, tileLen}, textureOrigin, 0, WHITE);
-            }
-        }
-        else { //Menu
+    // Draw
+    //----------------------------------------------------------------------------------
+    BeginDrawing();
+
+        DrawGame();
 
-        }
     EndDrawing();
     //----------------------------------------------------------------------------------
 
@@ -317,8 +385,13 @@ void UpdateDrawFrame(void) {
                 break;
             }
             case 2: {
-                gameStage = 0;
-                InitMap(&grid);
+                if (packLoaded) {
+                    LoadPackBoard();
+                } else {
+                    gameStage = 0;
+                    InitMap(&grid);
+                }
+                JournalClear(&journal);
                 break;
             }
             case 3: {
@@ -337,263 +410,63 @@ void UpdateDrawFrame(void) {
     }
 }
 
-// Initialise/Reset the map.
-void InitMap(struct Grid* gp) {
-
-    //printf("InitMap ran\n");
+// Pack the sprite sheet, its themes, the font and a white block for shapes into one texture.
+// Everything in a frame then comes from the same texture, so raylib never has to break its draw batch.
+// Returns 0 if the atlas texture couldn't be made. The font keeps its own texture then.
+int InitAtlas(void) {
+    Image images[THEME_COUNT + 2];
 
-    //bomb gen
-    //gp->bombCount = (int)(2.35 * sqrt(gp->len));
-    //gp->bombCount = 5;
-
-    grid.h = h;
-    grid.w = w;
-    grid.len = len;
-
-    grid.bombsFlagged = 0;
-    grid.flagCount = 0;
-    grid.tilesRevealed = 0;
-
-    for (int i = 0; i < gp->len; i++) {
-        gp->tiles[i] = UNREVEALED;
-        gp->map[i] = REVEALED;
-        gp->scanQue[i] = -1;
-        gp->tilesScanned[i] = -1;
-
-    }
-
-    for (int i = 0; i < gp->bombCount; i++) {
-        gp->map[i] = BOMB;
-    }
-}
-
-// Shuffle the map after user clicks the first tile. The initial 3x3 tiles the user clicks are always 0.
-void ShuffleMap(struct Grid* gp, int tileRevealed) {
-
-    //printf("ShuffleMap ran\n");
-
-    int tileX = tileRevealed % gp->w;
-    int tileY = tileRevealed / gp->w;
-
-
-    int tr, tl, bl, br;
-    tr = XYInBounds(gp, tileX+1, tileY+1);
-    tl = XYInBounds(gp, tileX-1, tileY+1);
-    bl = XYInBounds(gp, tileX-1, tileY-1);
-    br = XYInBounds(gp, tileX+1, tileY-1);
-
-    int edgeCount = tr + tl + bl + br;
-    int o = 10; //offset
-    if (edgeCount == 1) {
-        o = 7;
-    }
-    if (edgeCount == 2) {
-        o = 5;
-    }
+    images[0] = LoadImage("resources/spriteSheet.png");
+    images[1] = ImageCopy(images[0]);
+    ImageColorBrightness(&images[1], -80);
+    images[2] = ImageCopy(images[0]);
+    ImageColorTint(&images[2], (Color){150, 190, 255, 255});
+    images[THEME_COUNT] = LoadImageFromTexture(gameFont.texture);
+    images[THEME_COUNT + 1] = GenImageColor(3, 3, WHITE);
 
-    for (int i = gp->len - o; i > 0; i--) {
-        int r = rand() % i;
-        char t = gp->map[r];
-        gp->map[r] = gp->map[i];
-        gp->map[i] = t;
-    }
-
-    int surrounding_tiles[9] = {tileRevealed, (tileRevealed - gp->w) - 1, (tileRevealed - gp->w),
-        (tileRevealed - gp->w) + 1, tileRevealed - 1, tileRevealed + 1,
-        (tileRevealed + gp->w) - 1, (tileRevealed + gp->w), (tileRevealed + gp->w) + 1};
-
-    for (int i = 0; i < 9; i++) {
-        if (TileInBounds(gp, surrounding_tiles[i]) == 1) {
-            char t = gp->map[len - (i+1)];
-            gp->map[len - (i+1)] = gp->map[surrounding_tiles[i]];
-            gp->map[surrounding_tiles[i]] = t;
-        }
-    }
-}
-
-// Fill the map array with number tiles according to the bombs.
-void GenMap(struct Grid* gp) {
-    for (int i = 0; i < gp->len; i++) {
-        if (gp->map[i] != BOMB) {
-            int bombCount = GetSurroundingBombCount(gp, i);
-            if (bombCount != 0) {
-                gp->map[i] = NUM_TILE(bombCount);
-            }
-        } else {
-
-        }
-    }
-}
-
-// Convert a pixel on the map to the tile it corresponds to
-int PixelToGrid(struct Grid* gp, Vector2 origin, Vector2 mousePos) {
-
-    Vector2 pos = Vector2Subtract(mousePos, origin);
-
-    if (pos.x < 0 || pos.y < 0) {
-        return -1;
-    }
-
-    int gridX = pos.x / tileLen;
-    int gridY = pos.y / tileLen;
-
-    if (gridX >= gp->w || gridY >= gp->h) {
-        return -1;
-    }
-
-    return gridX + gridY * gp->w;
-}
-
-// Check if a given tile index is within the len of the map.
-int TileInBounds(struct Grid* gp, int tile) {
-    /*
-    int tileX = tile % gp->w;
-    int tileY = tile / gp->w;
-
-    return XYInBounds(gp, tileX, tileY);
-    */
-    if (tile >= 0 && tile < gp->len) {
-        return 1;
+    int built = BuildAtlas(&atlas, &images[0], THEME_COUNT + 2, 1);
+    for (int i = 0; i < THEME_COUNT + 2; i++) {
+        UnloadImage(images[i]);
     }
-    return 0;
-}
-
-// Check if given x and y are withing the grid.
-int XYInBounds(struct Grid* gp, int tileX, int tileY) {
-
-    if (tileX >= 0 && tileY >= 0 && tileX < gp->w && tileY < gp->h) {
-        return 1;
+    if (!built) {
+        return 0;
     }
-    return 0;
-}
 
-// Function to get address and values of surrounding tiles
-int GetSurroundingTiles(struct Grid* gp, int tile, int* surroundingTileAddresses, char* surroundingTiles) {
-    int tileX = tile % gp->w;
-    int tileY = tile / gp->w;
-
-    //printf("fetched surr. tiles. pos x:%d, y:%d\n", tileX, tileY);
-    int x, y;
-    int pos;
-
-    int bombCount = 0;
-
-    for (int i = 0; i < 9; i++) {
-        x = -1 + (i % 3);
-        y = -1 + (i / 3);
-        if (XYInBounds(gp, tileX + x, tileY + y) == 1) {
-            //gp->tiles[tile + x + (y * gp->w)] = FLAG; // DEBUG
-            pos = tile + x + (y * gp->w);
-            *(surroundingTileAddresses++) = pos;
-            *(surroundingTiles++) = gp->map[pos];
-            if (gp->map[pos] == BOMB) {
-                ++bombCount;
-            }
-        } else {
-            *(surroundingTileAddresses++) = -1;
-            *(surroundingTiles++) = -1;
+    for (int t = 0; t < THEME_COUNT; t++) {
+        for (int i = 0; i < textureCount; i++) {
+            themeSprites[t][i] = AtlasRec(&atlas, t, (Rectangle){(i % textureColumns) * textureSize, (i / textureColumns) * textureSize, textureSize, textureSize});
         }
     }
+    sprites = themeSprites[theme];
 
-    return bombCount;
+    AtlasFont(&atlas, THEME_COUNT, &gameFont);
+    SetShapesTexture(atlas.texture, AtlasRec(&atlas, THEME_COUNT + 1, (Rectangle){1, 1, 1, 1}));
+    return 1;
 }
 
-// Function to return # of bombs surrounding tile
-int GetSurroundingBombCount(struct Grid* gp, int tile) {
-    int tileX = tile % gp->w;
-    int tileY = tile / gp->w;
+// Draw the hud, menu and board for the current game state. Used by UpdateDrawFrame and the render benchmark.
+void DrawGame(void) {
+    ClearBackground(RAYWHITE);
 
-    //printf("pos x:%d, y:%d\n", tileX, tileY);
-    int x, y;
-    int pos;
+    //Draw hud and get cursor overlap
+    buttonSelected = DrawUI(mousePos, &hud, &menu);
+    //buttonSelected = 0;
 
-    int bombCount = 0;
+    if (gameStage != 2) { //Game
 
-    for (int i = 0; i < 9; i++) {
-        x = -1 + (i % 3);
-        y = -1 + (i / 3);
-        if (XYInBounds(gp, tileX + x, tileY + y) == 1) {
-            pos = tile + x + (y * gp->w);
-            if (gp->map[pos] == BOMB) {
-                ++bombCount;
-            }
-        }
-    }
+        //Rectangle around game field
+        DrawRectangle((int)startPos.x - 14, (int)startPos.y - 14, (int)gameSize.x + 14, (int)gameSize.y + 14, LIGHTGRAY);
 
-    return bombCount;
-}
+        // Bottom/Right line around game field
+        DrawRectangle((int)startPos.x - 8, (int)startPos.y - 8, (int)gameSize.x + 2, (int)gameSize.y + 2, BGGRAY);
 
-// Function to reveal a tile. Checks if new tile is bomb/not
-int RevealTile(struct Grid* gp, int gridPos) {
-    if (gp->tiles[gridPos] == UNREVEALED) {
-        if (gp->map[gridPos] == BOMB) {
-            return -1;
-        } else {
-            gp->tiles[gridPos] = gp->map[gridPos];
-            gp->tilesRevealed += 1;
-            return 1;
+        //Render grid
+        for (int i = 0; i < grid.len; i++) {
+            DrawTexturePro(atlas.texture, sprites[grid.tiles[i]], (Rectangle){(i % grid.w) * tileLen + startPos.x, (int)(i / grid.w) * tileLen + startPos.y, tileLen, tileLen}, textureOrigin, 0, WHITE);
         }
-
     }
-    return 0;
-}
+    else { //Menu
 
-// Function to flag/un-flag a tile
-void FlagTile(struct Grid* gp, int gridPos) {
-    if (gp->tiles[gridPos] == FLAG) {
-        gp->tiles[gridPos] = UNREVEALED;
-        gp->flagCount -= 1;
-        if (gp->map[gridPos] == BOMB) {
-            gp->bombsFlagged -= 1;
-        }
-    }
-    else if (gp->tiles[gridPos] == UNREVEALED) {
-        gp->tiles[gridPos] = FLAG;
-        gp->flagCount += 1;
-        if (gp->map[gridPos] == BOMB) {
-            gp->bombsFlagged += 1;
-        }
-    }
-}
-
-// Called when user reveals 0 tile to reveal all surrounding non-bomb tiles. Flood fill (?)
-// This function is so wierd. I give up.
-void RevealEmptyTiles(struct Grid* gp, int gridPos) {
-
-    int adjacentBombCount;
-
-
-    char loop = 10;
-
-
-    gp->quePos = 0;
-    gp->scanQue[0] = gridPos;
-    gp->tilesScanned[gridPos] = gridPos;
-
-    for (int i = 1; i < scanSize*gp->len && loop > 0;) {
-        if (i > gp->quePos) {
-            adjacentBombCount = GetSurroundingTiles(&grid, gp->scanQue[gp->quePos++], &surroundingTileAddresses[0], &surroundingTiles[0]);
-            loop -= 1;
-            if (adjacentBombCount == 0) {
-                for (int j = 0; j < 9; j++) {
-                    int scanPos = surroundingTileAddresses[j];
-                    if (scanPos != -1 && gp->tilesScanned[scanPos] != gridPos) {
-                        loop = 10;
-
-                        gp->tilesScanned[scanPos] = gridPos;
-                        gp->scanQue[i++] = scanPos;
-
-                        //gp->tiles[scanPos] = gp->map[scanPos];
-                        RevealTile(gp, scanPos);
-
-                        //printf("tile revealed. x: %d y: %d\n", scanPos % gp->w, scanPos / gp->w);
-                    }
-                }
-            }
-            printf("i: %d\n", i);
-        } else {
-            loop = 0;
-        }
     }
 }
 
@@ -785,6 +658,10 @@ int DrawUI(Vector2 mousePos, struct Hud* hudp, struct Menu* menup) {
 
     DrawTextFromStruct(&hudp->texts[4]);
 
+    if (practiceMode) {
+        DrawTextEx(gameFont, "Practice - Z: Undo, Y: Redo", (Vector2){8, screenHeight - (hudp->texts[4].size.y + 8)}, 18, 2, BLACK);
+    }
+
     return cursorPos;
 }
 
@@ -815,31 +692,12 @@ void LoseGame(struct Grid* gp, int gridPos) {
     gameStage = -1;
     for (int i = 0; i < gp->len; i++) {
         if (gp->map[i] == BOMB && gp->tiles[i] != FLAG) {
-            gp->tiles[i] = BOMB;
+            SetTile(gp, i, BOMB);
         } else if (gp->map[i] != BOMB && gp->tiles[i] == FLAG) {
-            gp->tiles[i] = BOMB_CROSS;
+            SetTile(gp, i, BOMB_CROSS);
         }
     }
-    gp->tiles[gridPos] = BOMB_RED;
-}
-
-// Called at the start to initialise difficulty structs.
-void InitDifficulty(void) {
-    //set difficulties
-    easy.h = 8;
-    easy.w = 12;
-    easy.bombCount = 20;
-    easy.difficulty = 0;
-
-    medium.h = 12;
-    medium.w = 16;
-    medium.bombCount = 36;
-    medium.difficulty = 1;
-
-    hard.h = 16;
-    hard.w = 24;
-    hard.bombCount = 80;
-    hard.difficulty = 2;
+    SetTile(gp, gridPos, BOMB_RED);
 }
 
 // Called when difficulty is updated. Modifies grid accordingly.
@@ -858,4 +716,216 @@ char UpdateDifficulty(struct Grid* gp, struct Setting* setting) {
 
 
     return setting->difficulty;
-}
\ No newline at end of file
+}
+
+// Deal the pack's board and open it from its start tile, as if that was the first click.
+void LoadPackBoard(void) {
+    struct Setting setting = {pack.h, pack.w, pack.bombCount, difficulty};
+    UpdateDifficulty(&grid, &setting);
+
+    int start = PackLoadMap(&pack, packBoard, &grid);
+    if (start < 0) {
+        printf("board %lld in the pack is damaged\n", packBoard);
+        gameStage = 0;
+        InitMap(&grid);
+        return;
+    }
+
+    gameStage = 1;
+    if (RevealTile(&grid, start) == 1 && grid.map[start] == REVEALED) {
+        RevealEmptyTiles(&grid, start);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Render benchmark
+//----------------------------------------------------------------------------------
+
+// Draw calls the batch will issue when it's flushed. Only right if the whole frame fits in the batch,
+// otherwise raylib flushes part of it early, see RENDER_BENCH_BATCH_ELEMENTS.
+int CountDrawCalls(rlRenderBatch* batch) {
+    int count = 0;
+    for (int i = 0; i < batch->drawCounter; i++) {
+        if (batch->draws[i].vertexCount > 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Put the game into a scripted state. Boards come from a fixed seed and are opened from the middle.
+void SetupScenario(struct Setting* setting, char stage) {
+    difficulty = UpdateDifficulty(&grid, setting);
+    SeedMap(&grid, 1);
+    InitMap(&grid);
+    gameStage = stage;
+
+    if (stage == 2) {
+        return;
+    }
+
+    int start = grid.len / 2 + grid.w / 2;
+    ShuffleMap(&grid, start);
+    GenMap(&grid);
+    if (RevealTile(&grid, start) == 1 && grid.map[start] == REVEALED) {
+        RevealEmptyTiles(&grid, start);
+    }
+
+    // Flag the first few mines
+    for (int i = 0, flagged = 0; i < grid.len && flagged < 3; i++) {
+        if (grid.map[i] == BOMB) {
+            FlagTile(&grid, i);
+            ++flagged;
+        }
+    }
+
+    if (stage == -1) {
+        for (int i = grid.len - 1; i >= 0; i--) {
+            if (grid.map[i] == BOMB && grid.tiles[i] != FLAG) {
+                LoseGame(&grid, i);
+                break;
+            }
+        }
+    } else if (stage == 3) {
+        for (int i = 0; i < grid.len; i++) {
+            if (grid.map[i] == BOMB) {
+                if (grid.tiles[i] != FLAG) {
+                    FlagTile(&grid, i);
+                }
+            } else {
+                RevealTile(&grid, i);
+            }
+        }
+    }
+}
+
+// Fraction of pixels where a channel differs by more than RENDER_BENCH_CHANNEL_TOLERANCE, 1 if the sizes differ.
+double CompareImages(Image a, Image b) {
+    if (a.width != b.width || a.height != b.height) {
+        return 1;
+    }
+
+    Color* ca = LoadImageColors(a);
+    Color* cb = LoadImageColors(b);
+    long long differ = 0;
+    long long count = (long long)a.width * a.height;
+
+    for (long long i = 0; i < count; i++) {
+        if (abs(ca[i].r - cb[i].r) > RENDER_BENCH_CHANNEL_TOLERANCE || abs(ca[i].g - cb[i].g) > RENDER_BENCH_CHANNEL_TOLERANCE
+            || abs(ca[i].b - cb[i].b) > RENDER_BENCH_CHANNEL_TOLERANCE || abs(ca[i].a - cb[i].a) > RENDER_BENCH_CHANNEL_TOLERANCE) {
+            ++differ;
+        }
+    }
+
+    UnloadImageColors(ca);
+    UnloadImageColors(cb);
+    return (double)differ / count;
+}
+
+int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Render every scenario frames times into an offscreen texture, print frame time and draw calls as JSON
+// lines and check the last frame against goldenDir/<scenario>.png. Returns 1 if any image is missing or
+// off by more than tolerance. Every frame ends by reading a pixel back, so its time includes the GPU
+// finishing it and not just queueing the draw calls.
+int RunRenderBench(int frames, const char* goldenDir, int updateGolden, double tolerance) {
+    struct {
+        const char* name;
+        struct Setting* setting;
+        char stage;
+    } scenarios[] = {
+        {"menu", &medium, 2},
+        {"easy-playing", &easy, 1}, {"easy-lost", &easy, -1}, {"easy-won", &easy, 3},
+        {"medium-playing", &medium, 1}, {"medium-lost", &medium, -1}, {"medium-won", &medium, 3},
+        {"hard-playing", &hard, 1}, {"hard-lost", &hard, -1}, {"hard-won", &hard, 3},
+    };
+    int scenarioCount = sizeof(scenarios) / sizeof(scenarios[0]);
+
+    if (frames < 1) {
+        frames = 1;
+    }
+    double* times = malloc(sizeof(double) * frames);
+    if (times == NULL) {
+        return 1;
+    }
+
+    RenderTexture2D target = LoadRenderTexture(screenWidth, screenHeight);
+
+    // Our own batch so the draw calls of a frame can be counted before it's flushed
+    rlRenderBatch batch = rlLoadRenderBatch(1, RENDER_BENCH_BATCH_ELEMENTS);
+    rlSetRenderBatchActive(&batch);
+
+    if (updateGolden) {
+        MakeDirectory(goldenDir);
+    }
+
+    mousePos = (Vector2){-100, -100}; //Nothing hovered
+    int failed = 0;
+
+    for (int s = 0; s < scenarioCount; s++) {
+        SetupScenario(scenarios[s].setting, scenarios[s].stage);
+
+        int drawCalls = 0;
+        for (int f = -RENDER_BENCH_WARMUP; f < frames; f++) {
+            double start = GetTime();
+            BeginTextureMode(target);
+                DrawGame();
+                drawCalls = CountDrawCalls(&batch);
+                rlDrawRenderBatchActive();
+                MemFree(rlReadScreenPixels(1, 1)); //Waits until the frame is drawn
+            EndTextureMode();
+            if (f >= 0) {
+                times[f] = GetTime() - start;
+            }
+        }
+
+        double total = 0;
+        for (int f = 0; f < frames; f++) {
+            total += times[f];
+        }
+        qsort(times, frames, sizeof(double), CompareDouble);
+
+        // Render textures are upside down
+        Image image = LoadImageFromTexture(target.texture);
+        ImageFlipVertical(&image);
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.png", goldenDir, scenarios[s].name);
+        const char* golden = "missing";
+        double differ = 0;
+
+        if (updateGolden) {
+            if (ExportImage(image, path)) {
+                golden = "updated";
+            } else {
+                golden = "write failed";
+                ++failed;
+            }
+        } else if (FileExists(path)) {
+            Image expected = LoadImage(path);
+            differ = CompareImages(image, expected);
+            golden = differ <= tolerance ? "match" : "mismatch";
+            failed += differ > tolerance;
+            UnloadImage(expected);
+        } else {
+            ++failed; //Run with --update-golden to create it
+        }
+        UnloadImage(image);
+
+        printf("{\"scenario\": \"%s\", \"w\": %d, \"h\": %d, \"frames\": %d, \"mean_us\": %.1f, \"p99_us\": %.1f, "
+               "\"draw_calls\": %d, \"golden\": \"%s\", \"pixels_differ\": %.5f}\n",
+               scenarios[s].name, grid.w, grid.h, frames, total / frames * 1e6, times[(frames - 1) * 99 / 100] * 1e6,
+               drawCalls, golden, differ);
+        fflush(stdout);
+    }
+
+    rlSetRenderBatchActive(NULL);
+    rlUnloadRenderBatch(batch);
+    UnloadRenderTexture(target);
+    free(times);
+    return failed > 0;
+}
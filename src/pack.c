@@ -0,0 +1,528 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    // Keep windows.h from declaring names raylib.h also uses (Rectangle, CloseWindow, DrawText, ...)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOGDI
+    #define NOUSER
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "pack.h"
+
+#define PACK_CODEC_BITMAP 0 //Any other codec byte is Rice coding with k = codec - 1
+#define PACK_MAX_RICE 24
+
+// Reads bits from a block, least significant bit first. A block is always followed by at least
+// 8 more bytes of the file (the next block or the index), so a whole word can be loaded anywhere before end.
+struct BitReader {
+    const unsigned char* data;
+    size_t pos, end; //In bits
+};
+
+//----------------------------------------------------------------------------------
+// Helpers
+//----------------------------------------------------------------------------------
+unsigned long long ReadLE(const unsigned char* p, int bytes) {
+    unsigned long long value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+void WriteLE(unsigned char* p, unsigned long long value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+// Bits needed to store a tile index
+int StartBits(int len) {
+    int bits = 1;
+    while ((1 << bits) < len) {
+        ++bits;
+    }
+    return bits;
+}
+
+// The next 57 bits, fewer are valid near the end of the block
+unsigned long long PeekBits(struct BitReader* br) {
+    unsigned long long word = 0;
+    for (int i = 7; i >= 0; i--) {
+        word = (word << 8) | br->data[(br->pos >> 3) + i];
+    }
+    return word >> (br->pos & 7);
+}
+
+// Up to 57 bits. Returns -1 past the end of the block.
+long long ReadBits(struct BitReader* br, int count) {
+    if (br->pos + count > br->end) {
+        return -1;
+    }
+    unsigned long long value = count == 0 ? 0 : PeekBits(br) & ((1ULL << count) - 1);
+    br->pos += count;
+    return (long long)value;
+}
+
+// Unary number: ones ended by a zero. Returns -1 if it runs past limit or the end of the block.
+long long ReadUnary(struct BitReader* br, long long limit) {
+    long long count = 0;
+    for (;;) {
+        if (br->pos >= br->end) {
+            return -1;
+        }
+        int ones = __builtin_ctzll(~PeekBits(br) | (1ULL << 57));
+        if (br->pos + ones >= br->end || count + ones > limit) {
+            return -1;
+        }
+        count += ones;
+        br->pos += ones;
+        if (ones < 57) {
+            ++br->pos;
+            return count;
+        }
+    }
+}
+
+// Skip past the next count zeros, i.e. count unary numbers. Returns 0 past the end of the block.
+int SkipUnary(struct BitReader* br, int count) {
+    const unsigned long long window = (1ULL << 57) - 1;
+    while (count > 0) {
+        if (br->pos >= br->end) {
+            return 0;
+        }
+        unsigned long long zeros = ~PeekBits(br) & window;
+        int found = __builtin_popcountll(zeros);
+        if (found < count) {
+            count -= found;
+            br->pos += 57;
+            continue;
+        }
+        for (int i = 1; i < count; i++) {
+            zeros &= zeros - 1;
+        }
+        br->pos += __builtin_ctzll(zeros) + 1;
+        count = 0;
+    }
+    return br->pos <= br->end;
+}
+
+// Map a whole file read-only. Returns NULL if it's empty or can't be mapped.
+const unsigned char* MapFile(const char* path, size_t* size) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < 1) {
+        CloseHandle(file);
+        return NULL;
+    }
+    // The view keeps the file and the mapping open until UnmapViewOfFile
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        return NULL;
+    }
+    *size = (size_t)fileSize.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 1) {
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return data;
+#endif
+}
+
+void UnmapFile(const unsigned char* data, size_t size) {
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+//----------------------------------------------------------------------------------
+// Reading
+//----------------------------------------------------------------------------------
+
+// Map a pack into memory and check its header. Returns 1 on success.
+int PackOpen(struct Pack* pack, const char* path) {
+    memset(pack, 0, sizeof(*pack));
+
+    pack->data = MapFile(path, &pack->size);
+    if (pack->data == NULL) {
+        return 0;
+    }
+    if (pack->size < PACK_HEADER_SIZE) {
+        PackClose(pack);
+        return 0;
+    }
+
+    const unsigned char* header = pack->data;
+    unsigned long long indexOffset = ReadLE(header + 48, 8);
+    unsigned long long dataOffset = ReadLE(header + 56, 8);
+    pack->w = (int)ReadLE(header + 12, 4);
+    pack->h = (int)ReadLE(header + 16, 4);
+    pack->bombCount = (int)ReadLE(header + 20, 4);
+    pack->boardsPerBlock = (int)ReadLE(header + 24, 4);
+    unsigned long long boardCount = ReadLE(header + 32, 8);
+    unsigned long long blockCount = ReadLE(header + 40, 8);
+
+    // Counts are checked unsigned, a damaged header can hold anything. Every block has an index entry,
+    // so the file size bounds blockCount, and blockCount bounds boardCount.
+    int ok = memcmp(header, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0 && ReadLE(header + 8, 4) == PACK_VERSION
+             && pack->w > 0 && pack->h > 0 && pack->w <= 65535 && pack->h <= 65535 && (long long)pack->w * pack->h <= (1 << 30)
+             && pack->bombCount >= 0 && pack->bombCount <= pack->w * pack->h
+             && pack->boardsPerBlock > 0
+             && dataOffset >= PACK_HEADER_SIZE && dataOffset <= indexOffset && indexOffset <= pack->size
+             && blockCount < (pack->size - indexOffset) / 8 && boardCount <= LLONG_MAX
+             && blockCount == boardCount / (unsigned int)pack->boardsPerBlock + (boardCount % (unsigned int)pack->boardsPerBlock != 0);
+
+    if (!ok) {
+        PackClose(pack);
+        return 0;
+    }
+
+    pack->boardCount = (long long)boardCount;
+    pack->blockCount = (long long)blockCount;
+
+    pack->blocks = pack->data + dataOffset;
+    pack->index = pack->data + indexOffset;
+    return 1;
+}
+
+void PackClose(struct Pack* pack) {
+    if (pack->data != NULL) {
+        UnmapFile(pack->data, pack->size);
+    }
+    memset(pack, 0, sizeof(*pack));
+}
+
+// Initialise the map from a board in the pack instead of ShuffleMap. Sets the grid's size and mine
+// count to the pack's, the grid's buffers must hold w * h tiles. Numbers are left to GenMap.
+// Returns the board's start tile, or -1 if the board doesn't exist or is damaged.
+int PackLoadMap(struct Pack* pack, long long board, struct Grid* gp) {
+    if (board < 0 || board >= pack->boardCount) {
+        return -1;
+    }
+
+    long long block = board / pack->boardsPerBlock;
+    int inBlock = (int)(board % pack->boardsPerBlock);
+    unsigned long long start = ReadLE(pack->index + 8 * block, 8);
+    unsigned long long end = ReadLE(pack->index + 8 * (block + 1), 8);
+    if (start >= end || end > (unsigned long long)(pack->index - pack->blocks)) {
+        return -1;
+    }
+
+    gp->w = pack->w;
+    gp->h = pack->h;
+    gp->len = pack->w * pack->h;
+    gp->bombCount = pack->bombCount;
+    InitMap(gp);
+
+    int len = gp->len;
+    int startBits = StartBits(len);
+    int codec = pack->blocks[start];
+    struct BitReader br = {pack->blocks + start + 1, 0, 8 * (end - start - 1)};
+
+    // A Rice board is the start tile, the high part of every gap in unary, then the low k bits of every gap.
+    // Only the unary part varies in size and it holds exactly bombCount zeros, so boards are skipped by counting zeros.
+    int k = codec - 1;
+    if (codec > PACK_MAX_RICE) {
+        return -1;
+    } else if (codec == PACK_CODEC_BITMAP) {
+        br.pos = (size_t)inBlock * (startBits + len);
+    } else {
+        for (int i = 0; i < inBlock; i++) {
+            br.pos += startBits;
+            if (!SkipUnary(&br, pack->bombCount)) {
+                return -1;
+            }
+            br.pos += (size_t)pack->bombCount * k;
+        }
+    }
+
+    long long startTile = ReadBits(&br, startBits);
+    if (startTile < 0 || startTile >= len) {
+        return -1;
+    }
+
+    for (int i = 0; i < len; i++) {
+        gp->map[i] = REVEALED;
+    }
+
+    int mines = 0;
+    if (codec == PACK_CODEC_BITMAP) {
+        for (int i = 0; i < len; i += 57) {
+            int count = len - i < 57 ? len - i : 57;
+            long long bits = ReadBits(&br, count);
+            if (bits < 0) {
+                return -1;
+            }
+            for (; bits != 0; bits &= bits - 1) {
+                gp->map[i + __builtin_ctzll((unsigned long long)bits)] = BOMB;
+                ++mines;
+            }
+        }
+    } else {
+        // The high parts go in scanQue until the low parts are read
+        int* high = gp->scanQue;
+        for (int j = 0; j < pack->bombCount; j++) {
+            long long q = ReadUnary(&br, len >> k);
+            if (q < 0) {
+                return -1;
+            }
+            high[j] = (int)q;
+        }
+        long long pos = -1;
+        for (; mines < pack->bombCount; mines++) {
+            long long r = ReadBits(&br, k);
+            if (r < 0) {
+                return -1;
+            }
+            pos += (((long long)high[mines] << k) | r) + 1;
+            if (pos >= len) {
+                return -1;
+            }
+            gp->map[pos] = BOMB;
+        }
+        for (int j = 0; j < pack->bombCount; j++) {
+            high[j] = -1;
+        }
+    }
+
+    if (mines != pack->bombCount || gp->map[startTile] == BOMB) {
+        return -1;
+    }
+    return (int)startTile;
+}
+
+//----------------------------------------------------------------------------------
+// Writing
+//----------------------------------------------------------------------------------
+void PutBits(unsigned char* bits, size_t* pos, unsigned long long value, int count) {
+    for (int i = 0; i < count; i++) {
+        bits[*pos >> 3] |= (unsigned char)(((value >> i) & 1) << (*pos & 7));
+        ++*pos;
+    }
+}
+
+// Encode the waiting boards as one block with whichever codec is smallest, and write it out.
+int FlushBlock(struct PackWriter* writer) {
+    if (writer->blockBoards == 0) {
+        return 1;
+    }
+
+    int len = writer->w * writer->h;
+    int n = writer->blockBoards;
+    int startBits = StartBits(len);
+
+    // Size of every codec in bits, bitmap first
+    unsigned long long best = (unsigned long long)n * (startBits + len);
+    int codec = PACK_CODEC_BITMAP;
+    for (int k = 0; k < PACK_MAX_RICE; k++) {
+        unsigned long long size = (unsigned long long)n * startBits;
+        for (int b = 0; b < n; b++) {
+            int* mines = &writer->mines[b * writer->bombCount];
+            for (int j = 0; j < writer->bombCount; j++) {
+                int gap = mines[j] - (j == 0 ? -1 : mines[j - 1]) - 1;
+                size += (gap >> k) + 1 + k;
+            }
+        }
+        if (size < best) {
+            best = size;
+            codec = k + 1;
+        }
+    }
+
+    size_t bytes = 1 + (best + 7) / 8;
+    if (bytes > writer->bitsCap) {
+        unsigned char* bits = realloc(writer->bits, bytes);
+        if (bits == NULL) {
+            return 0;
+        }
+        writer->bits = bits;
+        writer->bitsCap = bytes;
+    }
+    memset(writer->bits, 0, bytes);
+    writer->bits[0] = (unsigned char)codec;
+
+    unsigned char* bits = writer->bits + 1;
+    size_t pos = 0;
+    for (int b = 0; b < n; b++) {
+        int* mines = &writer->mines[b * writer->bombCount];
+        PutBits(bits, &pos, writer->starts[b], startBits);
+        if (codec == PACK_CODEC_BITMAP) {
+            for (int j = 0; j < writer->bombCount; j++) {
+                bits[(pos + mines[j]) >> 3] |= (unsigned char)(1 << ((pos + mines[j]) & 7));
+            }
+            pos += len;
+        } else {
+            int k = codec - 1;
+            for (int j = 0; j < writer->bombCount; j++) {
+                int gap = mines[j] - (j == 0 ? -1 : mines[j - 1]) - 1;
+                for (int q = gap >> k; q > 0; q--) {
+                    PutBits(bits, &pos, 1, 1);
+                }
+                PutBits(bits, &pos, 0, 1);
+            }
+            for (int j = 0; j < writer->bombCount; j++) {
+                int gap = mines[j] - (j == 0 ? -1 : mines[j - 1]) - 1;
+                PutBits(bits, &pos, (unsigned long long)gap, k);
+            }
+        }
+    }
+
+    long long block = (writer->boardCount - 1) / writer->boardsPerBlock;
+    if (block + 2 > writer->indexCap) {
+        long long cap = writer->indexCap * 2 > block + 2 ? writer->indexCap * 2 : block + 2;
+        unsigned long long* index = realloc(writer->index, sizeof(unsigned long long) * cap);
+        if (index == NULL) {
+            return 0;
+        }
+        writer->index = index;
+        writer->indexCap = cap;
+    }
+    writer->index[block] = writer->dataSize;
+
+    if (fwrite(writer->bits, 1, bytes, writer->file) != bytes) {
+        return 0;
+    }
+    writer->dataSize += bytes;
+    writer->blockBoards = 0;
+    return 1;
+}
+
+// Start a new pack file. Returns 1 on success.
+int PackWriterOpen(struct PackWriter* writer, const char* path, int w, int h, int bombCount, int boardsPerBlock) {
+    memset(writer, 0, sizeof(*writer));
+    if (w < 1 || h < 1 || w > 65535 || h > 65535 || (long long)w * h > (1 << 30) || bombCount < 0 || bombCount > w * h || boardsPerBlock < 1) {
+        return 0;
+    }
+
+    writer->w = w;
+    writer->h = h;
+    writer->bombCount = bombCount;
+    writer->boardsPerBlock = boardsPerBlock;
+    writer->mines = malloc(sizeof(int) * ((size_t)boardsPerBlock * bombCount + 1));
+    writer->starts = malloc(sizeof(int) * boardsPerBlock);
+    writer->file = fopen(path, "wb");
+
+    unsigned char header[PACK_HEADER_SIZE] = {0};
+    if (writer->mines == NULL || writer->starts == NULL || writer->file == NULL
+        || fwrite(header, 1, PACK_HEADER_SIZE, writer->file) != PACK_HEADER_SIZE) {
+        if (writer->file != NULL) {
+            fclose(writer->file);
+        }
+        free(writer->mines);
+        free(writer->starts);
+        memset(writer, 0, sizeof(*writer));
+        return 0;
+    }
+    return 1;
+}
+
+// Add a board. map holds BOMB for mines, like after ShuffleMap. startTile must not be a mine.
+// Returns 0 if the board doesn't match the pack or the write failed.
+int PackWriterAdd(struct PackWriter* writer, const char* map, int startTile) {
+    int len = writer->w * writer->h;
+    if (startTile < 0 || startTile >= len || map[startTile] == BOMB) {
+        return 0;
+    }
+
+    int* mines = &writer->mines[writer->blockBoards * writer->bombCount];
+    int count = 0;
+    for (int i = 0; i < len; i++) {
+        if (map[i] == BOMB) {
+            if (count == writer->bombCount) {
+                return 0;
+            }
+            mines[count++] = i;
+        }
+    }
+    if (count != writer->bombCount) {
+        return 0;
+    }
+
+    writer->starts[writer->blockBoards++] = startTile;
+    ++writer->boardCount;
+    if (writer->blockBoards == writer->boardsPerBlock) {
+        return FlushBlock(writer);
+    }
+    return 1;
+}
+
+// Write the last block, the index and the header, and close the file. Returns 1 on success.
+int PackWriterClose(struct PackWriter* writer) {
+    int ok = FlushBlock(writer);
+    long long blockCount = (writer->boardCount + writer->boardsPerBlock - 1) / writer->boardsPerBlock;
+
+    if (ok && blockCount + 1 > writer->indexCap) {
+        unsigned long long* index = realloc(writer->index, sizeof(unsigned long long) * (blockCount + 1));
+        ok = index != NULL;
+        if (ok) {
+            writer->index = index;
+            writer->indexCap = blockCount + 1;
+        }
+    }
+
+    if (ok) {
+        writer->index[blockCount] = writer->dataSize;
+        unsigned char entry[8];
+        for (long long i = 0; i <= blockCount && ok; i++) {
+            WriteLE(entry, writer->index[i], 8);
+            ok = fwrite(entry, 1, 8, writer->file) == 8;
+        }
+    }
+
+    if (ok) {
+        unsigned char header[PACK_HEADER_SIZE] = {0};
+        memcpy(header, PACK_MAGIC, sizeof(PACK_MAGIC));
+        WriteLE(header + 8, PACK_VERSION, 4);
+        WriteLE(header + 12, writer->w, 4);
+        WriteLE(header + 16, writer->h, 4);
+        WriteLE(header + 20, writer->bombCount, 4);
+        WriteLE(header + 24, writer->boardsPerBlock, 4);
+        WriteLE(header + 32, writer->boardCount, 8);
+        WriteLE(header + 40, blockCount, 8);
+        WriteLE(header + 48, PACK_HEADER_SIZE + writer->dataSize, 8);
+        WriteLE(header + 56, PACK_HEADER_SIZE, 8);
+        ok = fseek(writer->file, 0, SEEK_SET) == 0 && fwrite(header, 1, PACK_HEADER_SIZE, writer->file) == PACK_HEADER_SIZE;
+    }
+
+    ok = fclose(writer->file) == 0 && ok;
+    free(writer->mines);
+    free(writer->starts);
+    free(writer->bits);
+    free(writer->index);
+    memset(writer, 0, sizeof(*writer));
+    return ok;
+}
@@ -0,0 +1,63 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdio.h>
+
+#include "board.h"
+
+//----------------------------------------------------------------------------------
+// Board packs
+//
+// A file of pre-made boards that all share one size and mine count. Boards are stored in blocks of
+// boardsPerBlock. Each block is either plain bitmaps (one bit per tile) or Rice coded gaps between
+// mines, whichever is smaller. Every board also stores the tile the player starts from.
+//
+// Layout, all numbers little endian:
+//   header    64 bytes, see PACK_MAGIC and PackOpen
+//   blocks    block i starts at dataOffset + index[i]
+//   index     blockCount + 1 uint64 offsets, the last one is the end of the data
+//----------------------------------------------------------------------------------
+
+#define PACK_MAGIC "MSPACK1"
+#define PACK_VERSION 1
+#define PACK_HEADER_SIZE 64
+#define PACK_BLOCK_BOARDS 64 //Default boards per block
+
+// An open pack. The file is mapped, reading a board only touches that board's block.
+struct Pack {
+    const unsigned char* data;
+    size_t size;
+    int w, h, bombCount;
+    int boardsPerBlock;
+    long long boardCount;
+    long long blockCount;
+    const unsigned char* blocks;
+    const unsigned char* index;
+};
+
+struct PackWriter {
+    FILE* file;
+    int w, h, bombCount;
+    int boardsPerBlock;
+    long long boardCount;
+    unsigned long long dataSize;
+    int blockBoards; //Boards waiting in the current block
+    int* mines; //Mine positions of the waiting boards, bombCount each
+    int* starts;
+    unsigned char* bits; //Encoded block
+    size_t bitsCap;
+    unsigned long long* index;
+    long long indexCap;
+};
+
+//----------------------------------------------------------------------------------
+// Pack Functions Declaration
+//----------------------------------------------------------------------------------
+int PackOpen(struct Pack* pack, const char* path);
+void PackClose(struct Pack* pack);
+int PackLoadMap(struct Pack* pack, long long board, struct Grid* gp);
+int PackWriterOpen(struct PackWriter* writer, const char* path, int w, int h, int bombCount, int boardsPerBlock);
+int PackWriterAdd(struct PackWriter* writer, const char* map, int startTile);
+int PackWriterClose(struct PackWriter* writer);
+
+#endif
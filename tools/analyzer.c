@@ -0,0 +1,567 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+
+//----------------------------------------------------------------------------------
+// Board statistics analyzer
+//
+// Generates boards with the game's own ShuffleMap/GenMap and reports, per Setting:
+//  - 3BV: minimum number of clicks needed to clear the board
+//  - openings: number of zero areas and how many tiles clicking each one reveals
+//  - islands: groups of number tiles not touching any opening, each needs its own clicks
+//  - no-guess ratio: boards a simple solver clears from the first click without guessing
+//
+// Every board is opened from a first click drawn from its own seed, like a player clicking anywhere.
+// --click center opens every board from the middle instead. The JSON says which was used.
+//
+// Boards are split over worker threads in batches. Each thread has its own grid and
+// accumulators, merged when the Setting is done and printed as one JSON line.
+//
+// Usage: minesweeper_analyzer [--boards N] [--threads N] [--seed N] [--click random|center]
+//                             [--setting easy|medium|hard|WxH:M]...
+//----------------------------------------------------------------------------------
+
+#define BATCH_SIZE 1024
+#define MAX_SETTINGS 16
+
+struct Stats {
+    long long boards, noGuess;
+    long long bv3Sum, openingSum, islandSum;
+    long long* bv3; //Histograms, len + 1 bins each
+    long long* openings;
+    long long* openingSize;
+    long long* islands;
+    long long* islandSize;
+    long long* block;
+};
+
+struct Job {
+    struct Setting setting;
+    const char* name;
+    long long boardCount;
+    unsigned long long seed;
+    char centerClick; //Open every board from the middle instead of a random tile
+    atomic_llong nextBatch;
+    atomic_llong boardsDone;
+};
+
+// Queue of revealed numbers to look at again. A tile is queued at most once, so len entries are enough.
+struct Solver {
+    int* que;
+    char* inQue;
+    int head, count;
+};
+
+struct Worker {
+    pthread_t thread;
+    struct Job* job;
+    struct Grid grid;
+    struct Stats stats;
+    struct Solver solver;
+    int* islandQue;
+};
+
+//----------------------------------------------------------------------------------
+// Helpers
+//----------------------------------------------------------------------------------
+double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int AllocStats(struct Stats* sp, int len) {
+    memset(sp, 0, sizeof(*sp));
+    sp->block = calloc(5 * (len + 1), sizeof(long long));
+    if (sp->block == NULL) {
+        return 0;
+    }
+    sp->bv3 = sp->block;
+    sp->openings = sp->block + (len + 1);
+    sp->openingSize = sp->block + 2 * (len + 1);
+    sp->islands = sp->block + 3 * (len + 1);
+    sp->islandSize = sp->block + 4 * (len + 1);
+    return 1;
+}
+
+void MergeStats(struct Stats* dst, struct Stats* src, int len) {
+    dst->boards += src->boards;
+    dst->noGuess += src->noGuess;
+    dst->bv3Sum += src->bv3Sum;
+    dst->openingSum += src->openingSum;
+    dst->islandSum += src->islandSum;
+    for (int i = 0; i < 5 * (len + 1); i++) {
+        dst->block[i] += src->block[i];
+    }
+}
+
+// Left click on a tile, as the game does it. Returns -1 on a bomb.
+int OpenTile(struct Grid* gp, int tile) {
+    int revealed = RevealTile(gp, tile);
+    if (revealed == 1 && gp->map[tile] == REVEALED) {
+        RevealEmptyTiles(gp, tile);
+    }
+    return revealed;
+}
+
+int Adjacent(struct Grid* gp, int a, int b) {
+    return abs(a % gp->w - b % gp->w) <= 1 && abs(a / gp->w - b / gp->w) <= 1;
+}
+
+//----------------------------------------------------------------------------------
+// Board analysis
+//----------------------------------------------------------------------------------
+
+// Count 3BV, openings and islands of a generated board.
+void AnalyzeBoard(struct Grid* gp, struct Stats* sp, int* que) {
+    ResetTiles(gp);
+
+    int bv3 = 0;
+    int openings = 0;
+    int islands = 0;
+
+    // Every opening is one click, whatever it reveals
+    for (int i = 0; i < gp->len; i++) {
+        if (gp->map[i] == REVEALED && gp->tiles[i] == UNREVEALED) {
+            int before = gp->tilesRevealed;
+            OpenTile(gp, i);
+            ++bv3;
+            ++openings;
+            sp->openingSize[gp->tilesRevealed - before] += 1;
+        }
+    }
+
+    // Numbers left over need one click each. Group them into 8-connected islands.
+    for (int i = 0; i < gp->len; i++) {
+        if (gp->map[i] == BOMB || gp->tiles[i] != UNREVEALED) {
+            continue;
+        }
+
+        int queLen = 0;
+        int quePos = 0;
+        que[queLen++] = i;
+        gp->tiles[i] = gp->map[i];
+
+        while (quePos < queLen) {
+            int tile = que[quePos++];
+            int tileX = tile % gp->w;
+            int tileY = tile / gp->w;
+            for (int y = tileY - 1; y <= tileY + 1; y++) {
+                for (int x = tileX - 1; x <= tileX + 1; x++) {
+                    int pos = x + y * gp->w;
+                    if (XYInBounds(gp, x, y) == 1 && gp->map[pos] != BOMB && gp->tiles[pos] == UNREVEALED) {
+                        gp->tiles[pos] = gp->map[pos];
+                        que[queLen++] = pos;
+                    }
+                }
+            }
+        }
+
+        bv3 += queLen;
+        ++islands;
+        sp->islandSize[queLen] += 1;
+    }
+
+    sp->bv3[bv3] += 1;
+    sp->openings[openings] += 1;
+    sp->islands[islands] += 1;
+    sp->bv3Sum += bv3;
+    sp->openingSum += openings;
+    sp->islandSum += islands;
+}
+
+// Queue every revealed number around a tile that just changed.
+void PushAround(struct Grid* gp, struct Solver* sp, int tile) {
+    int tileX = tile % gp->w;
+    int tileY = tile / gp->w;
+    for (int y = tileY - 1; y <= tileY + 1; y++) {
+        for (int x = tileX - 1; x <= tileX + 1; x++) {
+            int pos = x + y * gp->w;
+            if (XYInBounds(gp, x, y) == 1 && gp->tiles[pos] > NUM_TILE(0) && !sp->inQue[pos]) {
+                sp->inQue[pos] = 1;
+                sp->que[(sp->head + sp->count++) % gp->len] = pos;
+            }
+        }
+    }
+}
+
+void SolverOpen(struct Grid* gp, struct Solver* sp, int tile) {
+    int revealed = OpenTile(gp, tile);
+    if (revealed == 1 && gp->map[tile] == REVEALED) {
+        // RevealEmptyTiles leaves every tile it scanned in scanQue
+        for (int i = 0; i < gp->quePos; i++) {
+            PushAround(gp, sp, gp->scanQue[i]);
+        }
+    } else if (revealed == 1) {
+        PushAround(gp, sp, tile);
+    }
+}
+
+void SolverFlag(struct Grid* gp, struct Solver* sp, int tile) {
+    FlagTile(gp, tile);
+    PushAround(gp, sp, tile);
+}
+
+// Apply the single tile rules around a revealed number. Returns 1 if anything changed.
+int SolveTile(struct Grid* gp, struct Solver* sp, int tile) {
+    int number = gp->tiles[tile] - NUM_TILE(0);
+    int unknown = 0;
+    int flagged = 0;
+    int neighbours[9];
+    char values[9];
+
+    GetSurroundingTiles(gp, tile, &neighbours[0], &values[0]);
+
+    for (int j = 0; j < 9; j++) {
+        if (neighbours[j] == -1) continue;
+        if (gp->tiles[neighbours[j]] == UNREVEALED) ++unknown;
+        if (gp->tiles[neighbours[j]] == FLAG) ++flagged;
+    }
+
+    if (unknown == 0 || (number - flagged != unknown && number != flagged)) {
+        return 0;
+    }
+
+    for (int j = 0; j < 9; j++) {
+        if (neighbours[j] == -1 || gp->tiles[neighbours[j]] != UNREVEALED) continue;
+        if (number - flagged == unknown) {
+            SolverFlag(gp, sp, neighbours[j]);
+        } else {
+            SolverOpen(gp, sp, neighbours[j]);
+        }
+    }
+    return 1;
+}
+
+// Unknown tiles around a revealed number and the mines still hidden among them.
+int GetUnknownTiles(struct Grid* gp, int tile, int* unknown, int* remaining) {
+    int neighbours[9];
+    char values[9];
+    int count = 0;
+
+    *remaining = gp->tiles[tile] - NUM_TILE(0);
+    GetSurroundingTiles(gp, tile, &neighbours[0], &values[0]);
+
+    for (int j = 0; j < 9; j++) {
+        if (neighbours[j] == -1) continue;
+        if (gp->tiles[neighbours[j]] == FLAG) --*remaining;
+        if (gp->tiles[neighbours[j]] == UNREVEALED) unknown[count++] = neighbours[j];
+    }
+    return count;
+}
+
+// Subset rule: if the unknown tiles around a are all around b too, the rest of b's unknown tiles
+// hold exactly the difference in remaining mines. Returns 1 if anything changed.
+int SolvePair(struct Grid* gp, struct Solver* sp, int a, int* unknownA, int countA, int remainingA, int b) {
+    for (int j = 0; j < countA; j++) {
+        if (!Adjacent(gp, unknownA[j], b)) {
+            return 0;
+        }
+    }
+
+    int unknownB[9];
+    int remainingB;
+    int countB = GetUnknownTiles(gp, b, &unknownB[0], &remainingB);
+
+    int diff[9];
+    int diffCount = 0;
+    for (int j = 0; j < countB; j++) {
+        if (!Adjacent(gp, unknownB[j], a)) {
+            diff[diffCount++] = unknownB[j];
+        }
+    }
+
+    int mines = remainingB - remainingA;
+    if (diffCount == 0 || (mines != 0 && mines != diffCount)) {
+        return 0;
+    }
+
+    for (int j = 0; j < diffCount; j++) {
+        if (mines == 0) {
+            SolverOpen(gp, sp, diff[j]);
+        } else {
+            SolverFlag(gp, sp, diff[j]);
+        }
+    }
+    return 1;
+}
+
+// Look for one pair of numbers the subset rule applies to. Returns 1 if anything changed.
+int SolveAnyPair(struct Grid* gp, struct Solver* sp) {
+    int unknownA[9];
+    int remainingA;
+
+    for (int a = 0; a < gp->len; a++) {
+        if (gp->tiles[a] <= NUM_TILE(0)) {
+            continue;
+        }
+        int countA = GetUnknownTiles(gp, a, &unknownA[0], &remainingA);
+        if (countA == 0) {
+            continue;
+        }
+        int aX = a % gp->w;
+        int aY = a / gp->w;
+        for (int y = aY - 2; y <= aY + 2; y++) {
+            for (int x = aX - 2; x <= aX + 2; x++) {
+                int b = x + y * gp->w;
+                if (XYInBounds(gp, x, y) == 1 && b != a && gp->tiles[b] > NUM_TILE(0) &&
+                    SolvePair(gp, sp, a, &unknownA[0], countA, remainingA, b)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Play the board from the first click with deduction only. Returns 1 if it was cleared.
+// Single tile rules run off the queue; the slower pair search only runs when they're stuck.
+int SolveNoGuess(struct Grid* gp, struct Solver* sp, int click) {
+    ResetTiles(gp);
+    memset(sp->inQue, 0, gp->len);
+    sp->head = 0;
+    sp->count = 0;
+
+    SolverOpen(gp, sp, click);
+
+    int safeCount = gp->len - gp->bombCount;
+
+    for (;;) {
+        while (sp->count > 0) {
+            int tile = sp->que[sp->head];
+            sp->head = (sp->head + 1) % gp->len;
+            sp->count--;
+            sp->inQue[tile] = 0;
+            SolveTile(gp, sp, tile);
+        }
+
+        if (gp->tilesRevealed == safeCount || !SolveAnyPair(gp, sp)) {
+            break;
+        }
+    }
+
+    return gp->tilesRevealed == safeCount;
+}
+
+//----------------------------------------------------------------------------------
+// Workers
+//----------------------------------------------------------------------------------
+void* WorkerMain(void* arg) {
+    struct Worker* wp = arg;
+    struct Job* job = wp->job;
+    struct Grid* gp = &wp->grid;
+
+    long long batchCount = (job->boardCount + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (;;) {
+        long long batch = atomic_fetch_add(&job->nextBatch, 1);
+        if (batch >= batchCount) {
+            break;
+        }
+
+        long long first = batch * BATCH_SIZE;
+        long long last = first + BATCH_SIZE;
+        if (last > job->boardCount) {
+            last = job->boardCount;
+        }
+
+        for (long long board = first; board < last; board++) {
+            // Seeded per board, so results don't depend on the thread count
+            SeedBoard(gp, job->seed, board);
+            int click = job->centerClick ? gp->w / 2 + (gp->h / 2) * gp->w : RandomTile(gp);
+            ShuffleMap(gp, click);
+            GenMap(gp);
+
+            AnalyzeBoard(gp, &wp->stats, wp->islandQue);
+            wp->stats.noGuess += SolveNoGuess(gp, &wp->solver, click);
+            wp->stats.boards += 1;
+        }
+
+        atomic_fetch_add(&job->boardsDone, last - first);
+    }
+
+    return NULL;
+}
+
+int InitWorker(struct Worker* wp, struct Job* job) {
+    struct Grid* gp = &wp->grid;
+    memset(wp, 0, sizeof(*wp));
+    wp->job = job;
+
+    int ok = AllocGrid(gp, job->setting.w, job->setting.h, job->setting.bombCount);
+    wp->islandQue = malloc(sizeof(int) * gp->len);
+    wp->solver.que = malloc(sizeof(int) * gp->len);
+    wp->solver.inQue = malloc(gp->len);
+
+    if (!ok || wp->islandQue == NULL || wp->solver.que == NULL || wp->solver.inQue == NULL) {
+        return 0;
+    }
+
+    return AllocStats(&wp->stats, gp->len);
+}
+
+void FreeWorker(struct Worker* wp) {
+    FreeGrid(&wp->grid);
+    free(wp->islandQue);
+    free(wp->solver.que);
+    free(wp->solver.inQue);
+    free(wp->stats.block);
+}
+
+//----------------------------------------------------------------------------------
+// Output
+//----------------------------------------------------------------------------------
+void PrintHistogram(const char* name, long long* hist, int len, long long sum, long long count) {
+    printf(", \"%s\": {\"mean\": %.4f, \"hist\": [", name, count > 0 ? (double)sum / count : 0.0);
+    int first = 1;
+    for (int i = 0; i <= len; i++) {
+        if (hist[i] != 0) {
+            printf("%s[%d, %lld]", first ? "" : ", ", i, hist[i]);
+            first = 0;
+        }
+    }
+    printf("]}");
+}
+
+void PrintStats(struct Job* job, struct Stats* sp, double seconds, int threads) {
+    int len = job->setting.h * job->setting.w;
+    long long openingTiles = 0;
+    long long islandTiles = 0;
+    for (int i = 0; i <= len; i++) {
+        openingTiles += i * sp->openingSize[i];
+        islandTiles += i * sp->islandSize[i];
+    }
+
+    printf("{\"setting\": \"%s\", \"w\": %d, \"h\": %d, \"bombs\": %d, \"boards\": %lld, \"threads\": %d, \"seed\": %llu, "
+           "\"first_click\": \"%s\", \"seconds\": %.3f, \"boards_per_sec\": %.1f, \"no_guess_ratio\": %.6f",
+           job->name, job->setting.w, job->setting.h, job->setting.bombCount, sp->boards, threads, job->seed,
+           job->centerClick ? "center" : "random", seconds, seconds > 0 ? sp->boards / seconds : 0.0, sp->boards > 0 ? (double)sp->noGuess / sp->boards : 0.0);
+    PrintHistogram("bv3", sp->bv3, len, sp->bv3Sum, sp->boards);
+    PrintHistogram("openings", sp->openings, len, sp->openingSum, sp->boards);
+    PrintHistogram("opening_size", sp->openingSize, len, openingTiles, sp->openingSum);
+    PrintHistogram("islands", sp->islands, len, sp->islandSum, sp->boards);
+    PrintHistogram("island_size", sp->islandSize, len, islandTiles, sp->islandSum);
+    printf("}\n");
+    fflush(stdout);
+}
+
+// Run every board of a Setting over the worker threads and print the merged result.
+int RunJob(struct Job* job, int threads) {
+    struct Worker* workers = calloc(threads, sizeof(struct Worker));
+    if (workers == NULL) {
+        return 0;
+    }
+
+    atomic_init(&job->nextBatch, 0);
+    atomic_init(&job->boardsDone, 0);
+
+    double start = NowSeconds();
+
+    int started = 0;
+    for (; started < threads; started++) {
+        if (!InitWorker(&workers[started], job) || pthread_create(&workers[started].thread, NULL, WorkerMain, &workers[started]) != 0) {
+            FreeWorker(&workers[started]);
+            break;
+        }
+    }
+
+    double lastReport = start;
+    while (started > 0 && atomic_load(&job->boardsDone) < job->boardCount) {
+        struct timespec wait = {0, 20000000};
+        nanosleep(&wait, NULL);
+        if (NowSeconds() - lastReport >= 1.0) {
+            long long done = atomic_load(&job->boardsDone);
+            lastReport = NowSeconds();
+            fprintf(stderr, "\r%s: %lld/%lld boards (%.0f/s)", job->name, done, job->boardCount, done / (lastReport - start));
+        }
+    }
+
+    struct Stats total;
+    int len = job->setting.h * job->setting.w;
+    int ok = started > 0 && AllocStats(&total, len);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (ok) {
+            MergeStats(&total, &workers[i].stats, len);
+        }
+        FreeWorker(&workers[i]);
+    }
+    free(workers);
+
+    double seconds = NowSeconds() - start;
+
+    if (!ok) {
+        fprintf(stderr, "%s: failed to start workers\n", job->name);
+        return 0;
+    }
+
+    fprintf(stderr, "\r%s: %lld boards done%20s\n", job->name, total.boards, "");
+    PrintStats(job, &total, seconds, started);
+    free(total.block);
+    return 1;
+}
+
+//----------------------------------------------------------------------------------
+// Main Entry Point
+//----------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    long long boardCount = 1000000;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long long seed = 1;
+    char centerClick = 0;
+    const char* settingNames[MAX_SETTINGS];
+    int settingCount = 0;
+
+    InitDifficulty();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--boards") == 0 && i + 1 < argc) {
+            boardCount = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--click") == 0 && i + 1 < argc && (strcmp(argv[i + 1], "random") == 0 || strcmp(argv[i + 1], "center") == 0)) {
+            centerClick = strcmp(argv[++i], "center") == 0;
+        } else if (strcmp(argv[i], "--setting") == 0 && i + 1 < argc && settingCount < MAX_SETTINGS) {
+            settingNames[settingCount++] = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--boards N] [--threads N] [--seed N] [--click random|center] [--setting easy|medium|hard|WxH:M]...\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (threads < 1) threads = 1;
+    if (boardCount < 0) boardCount = 0;
+
+    if (settingCount == 0) {
+        settingNames[settingCount++] = "easy";
+        settingNames[settingCount++] = "medium";
+        settingNames[settingCount++] = "hard";
+    }
+
+    for (int i = 0; i < settingCount; i++) {
+        struct Job job;
+        if (!ParseSetting(settingNames[i], &job.setting)) {
+            fprintf(stderr, "invalid setting: %s\n", settingNames[i]);
+            return 2;
+        }
+        job.name = settingNames[i];
+        job.boardCount = boardCount;
+        job.seed = seed;
+        job.centerClick = centerClick;
+
+        if (!RunJob(&job, threads)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "pack.h"
+
+//----------------------------------------------------------------------------------
+// Board pack tool
+//
+//  write: deals boards with the game's ShuffleMap, each from a random first click that becomes the
+//         board's start tile, writes them to a pack and reads every board back to check it.
+//  info:  prints the header, bytes per board and the time to open the pack and load random boards.
+//  show:  prints one board.
+//
+// Usage: minesweeper_pack write OUT [--boards N] [--seed N] [--block N] [--setting easy|medium|hard|WxH:M]
+//        minesweeper_pack info PACK
+//        minesweeper_pack show PACK BOARD
+//----------------------------------------------------------------------------------
+
+double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Board number board of a pack dealt from seed. Returns the start tile.
+int DealBoard(struct Grid* gp, struct Setting* setting, unsigned long long seed, long long board) {
+    gp->w = setting->w;
+    gp->h = setting->h;
+    gp->len = setting->w * setting->h;
+    gp->bombCount = setting->bombCount;
+    SeedBoard(gp, seed, board);
+    InitMap(gp);
+    int start = RandomTile(gp);
+    ShuffleMap(gp, start);
+    return start;
+}
+
+int WritePack(const char* path, struct Setting* setting, long long boardCount, unsigned long long seed, int boardsPerBlock) {
+    struct Grid grid, loaded;
+    int len = setting->w * setting->h;
+    if (!AllocGrid(&grid, setting->w, setting->h, setting->bombCount) || !AllocGrid(&loaded, setting->w, setting->h, setting->bombCount)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    struct PackWriter writer;
+    if (!PackWriterOpen(&writer, path, setting->w, setting->h, setting->bombCount, boardsPerBlock)) {
+        fprintf(stderr, "can't write %s\n", path);
+        return 1;
+    }
+
+    double start = NowSeconds();
+    for (long long board = 0; board < boardCount; board++) {
+        int startTile = DealBoard(&grid, setting, seed, board);
+        if (!PackWriterAdd(&writer, grid.map, startTile)) {
+            fprintf(stderr, "failed to write board %lld\n", board);
+            PackWriterClose(&writer);
+            return 1;
+        }
+    }
+    if (!PackWriterClose(&writer)) {
+        fprintf(stderr, "failed to finish %s\n", path);
+        return 1;
+    }
+    double writeSeconds = NowSeconds() - start;
+
+    // Read everything back
+    struct Pack pack;
+    if (!PackOpen(&pack, path)) {
+        fprintf(stderr, "can't read back %s\n", path);
+        return 1;
+    }
+    start = NowSeconds();
+    for (long long board = 0; board < boardCount; board++) {
+        int startTile = DealBoard(&grid, setting, seed, board);
+        if (PackLoadMap(&pack, board, &loaded) != startTile || memcmp(grid.map, loaded.map, len) != 0) {
+            fprintf(stderr, "board %lld doesn't match after reading it back\n", board);
+            PackClose(&pack);
+            return 1;
+        }
+    }
+    double readSeconds = NowSeconds() - start;
+
+    printf("{\"pack\": \"%s\", \"boards\": %lld, \"bytes\": %zu, \"bytes_per_board\": %.2f, \"bitmap_bytes_per_board\": %.2f, "
+           "\"write_seconds\": %.3f, \"verify_seconds\": %.3f}\n",
+           path, boardCount, pack.size, boardCount > 0 ? (double)pack.size / boardCount : 0.0, (len + 7) / 8.0,
+           writeSeconds, readSeconds);
+
+    PackClose(&pack);
+    FreeGrid(&grid);
+    FreeGrid(&loaded);
+    return 0;
+}
+
+int PackInfo(const char* path) {
+    struct Pack pack;
+    double start = NowSeconds();
+    if (!PackOpen(&pack, path)) {
+        fprintf(stderr, "can't open %s\n", path);
+        return 1;
+    }
+    double openSeconds = NowSeconds() - start;
+
+    struct Grid grid;
+    if (!AllocGrid(&grid, pack.w, pack.h, pack.bombCount)) {
+        fprintf(stderr, "out of memory\n");
+        FreeGrid(&grid);
+        PackClose(&pack);
+        return 1;
+    }
+
+    // Random access time, board numbers from a fixed LCG so runs are comparable
+    int loads = pack.boardCount > 0 ? 100000 : 0;
+    int damaged = 0;
+    unsigned long long rng = 1;
+    start = NowSeconds();
+    for (int i = 0; i < loads; i++) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        damaged += PackLoadMap(&pack, (long long)((rng >> 17) % (unsigned long long)pack.boardCount), &grid) < 0;
+    }
+    double loadSeconds = NowSeconds() - start;
+
+    printf("{\"pack\": \"%s\", \"w\": %d, \"h\": %d, \"bombs\": %d, \"boards\": %lld, \"boards_per_block\": %d, \"blocks\": %lld, "
+           "\"bytes\": %zu, \"bytes_per_board\": %.2f, \"open_us\": %.1f, \"load_ns\": %.0f, \"damaged\": %d}\n",
+           path, pack.w, pack.h, pack.bombCount, pack.boardCount, pack.boardsPerBlock, pack.blockCount,
+           pack.size, pack.boardCount > 0 ? (double)pack.size / pack.boardCount : 0.0, openSeconds * 1e6,
+           loads > 0 ? loadSeconds * 1e9 / loads : 0.0, damaged);
+
+    PackClose(&pack);
+    FreeGrid(&grid);
+    return damaged > 0;
+}
+
+int PackShow(const char* path, long long board) {
+    struct Pack pack;
+    if (!PackOpen(&pack, path)) {
+        fprintf(stderr, "can't open %s\n", path);
+        return 1;
+    }
+
+    struct Grid grid;
+    if (!AllocGrid(&grid, pack.w, pack.h, pack.bombCount)) {
+        fprintf(stderr, "out of memory\n");
+        FreeGrid(&grid);
+        PackClose(&pack);
+        return 1;
+    }
+
+    int start = PackLoadMap(&pack, board, &grid);
+    if (start < 0) {
+        fprintf(stderr, "no board %lld in %s\n", board, path);
+        FreeGrid(&grid);
+        PackClose(&pack);
+        return 1;
+    }
+    GenMap(&grid);
+
+    for (int i = 0; i < grid.len; i++) {
+        char c = '.';
+        if (grid.map[i] == BOMB) {
+            c = '*';
+        } else if (grid.map[i] >= NUM_TILE(1)) {
+            c = (char)('0' + grid.map[i] - NUM_TILE(0));
+        }
+        putchar(i == start ? 'S' : c);
+        if (i % grid.w == grid.w - 1) {
+            putchar('\n');
+        }
+    }
+
+    PackClose(&pack);
+    FreeGrid(&grid);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------
+// Main Entry Point
+//----------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    const char* usage = "usage: %s write OUT [--boards N] [--seed N] [--block N] [--setting easy|medium|hard|WxH:M]\n"
+                        "       %s info PACK\n"
+                        "       %s show PACK BOARD\n";
+
+    InitDifficulty();
+
+    if (argc == 3 && strcmp(argv[1], "info") == 0) {
+        return PackInfo(argv[2]);
+    }
+    if (argc == 4 && strcmp(argv[1], "show") == 0) {
+        return PackShow(argv[2], atoll(argv[3]));
+    }
+    if (argc < 3 || strcmp(argv[1], "write") != 0) {
+        fprintf(stderr, usage, argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    long long boardCount = 100000;
+    unsigned long long seed = 1;
+    int boardsPerBlock = PACK_BLOCK_BOARDS;
+    struct Setting setting = medium;
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--boards") == 0 && i + 1 < argc) {
+            boardCount = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+            boardsPerBlock = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--setting") == 0 && i + 1 < argc && ParseSetting(argv[i + 1], &setting)) {
+            ++i;
+        } else {
+            fprintf(stderr, usage, argv[0], argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (boardCount < 0) boardCount = 0;
+    if (boardsPerBlock < 1) boardsPerBlock = 1;
+
+    return WritePack(argv[2], &setting, boardCount, seed, boardsPerBlock);
+}